@@ -0,0 +1,2 @@
+-- random UUIDs (gen_random_uuid is built-in since PostgreSQL 13)
+INSERT INTO bench_uuids (id, payload) VALUES (gen_random_uuid(), repeat('x', :payload));
@@ -0,0 +1,166 @@
+#!/usr/bin/env bash
+#
+# bench/run.sh
+#	compare UUID generators on insert throughput and index locality
+#
+# For each combination of generator, block size and number of clients, the
+# script recreates the bench_uuids table (with a primary key on the UUID
+# column), preloads it with PRELOAD rows and then runs the corresponding
+# pgbench script for DURATION seconds. The results are printed as CSV, one
+# line per run:
+#
+#	generator,block_size,block_count,clients,tps,wal_bytes,wal_fpi,
+#	index_bytes,index_hit_ratio,io_hit_ratio
+#
+# wal_fpi requires PostgreSQL 14 (pg_stat_wal), io_hit_ratio requires
+# PostgreSQL 16 (pg_stat_io), otherwise the columns are empty. The hit
+# ratios are computed from reads/hits during the measured run only.
+#
+# The database has to have the sequential_uuids extension installed. To
+# see the effect of locality, the index should not fit into shared buffers
+# (or RAM) - size PRELOAD and shared_buffers accordingly.
+#
+# Configuration (environment variables):
+#
+#	PGDATABASE, PGHOST, ...	connection parameters (used by psql/pgbench)
+#	GENERATORS		generators to test (random, sequence, time)
+#	BLOCK_SIZES		block sizes (for time, interval lengths in seconds)
+#	BLOCK_COUNT		number of blocks / intervals
+#	CLIENTS			numbers of concurrent clients
+#	DURATION		duration of each run (seconds)
+#	PRELOAD			number of rows loaded before each run
+#	PAYLOAD			length of the payload column
+#
+# Example:
+#
+#	PGDATABASE=bench BLOCK_SIZES="256 65536" CLIENTS="1 16" ./run.sh > results.csv
+#
+
+set -e
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+
+GENERATORS=${GENERATORS:-"random sequence time"}
+BLOCK_SIZES=${BLOCK_SIZES:-"256 65536"}
+BLOCK_COUNT=${BLOCK_COUNT:-65536}
+CLIENTS=${CLIENTS:-"1 8 32"}
+DURATION=${DURATION:-60}
+PRELOAD=${PRELOAD:-1000000}
+PAYLOAD=${PAYLOAD:-100}
+
+PSQL="psql -X -q -t -A -v ON_ERROR_STOP=1"
+
+server_version=$($PSQL -c "SHOW server_version_num")
+
+# expression generating the UUID, used for preloading the table
+generator_expr()
+{
+	case "$1" in
+		random)
+			echo "gen_random_uuid()"
+			;;
+		sequence)
+			echo "uuid_sequence_nextval('bench_uuids_seq'::regclass, $2, $BLOCK_COUNT)"
+			;;
+		time)
+			echo "uuid_time_nextval($2, $BLOCK_COUNT)"
+			;;
+		*)
+			echo "unknown generator: $1" >&2
+			exit 1
+			;;
+	esac
+}
+
+# WAL position, full page images, and shared buffer hits/reads (for all
+# relations and for the index) so far, as a comma-separated list
+stats_snapshot()
+{
+	local fpi="NULL"
+	local io="NULL, NULL"
+
+	if [ "$server_version" -ge 140000 ]; then
+		fpi="(SELECT wal_fpi FROM pg_stat_wal)"
+	fi
+
+	if [ "$server_version" -ge 160000 ]; then
+		io="(SELECT sum(hits) FROM pg_stat_io WHERE object = 'relation'),
+			(SELECT sum(reads) FROM pg_stat_io WHERE object = 'relation')"
+	fi
+
+	$PSQL -F ',' -c "SELECT pg_current_wal_lsn(), $fpi, $io, idx_blks_hit, idx_blks_read
+		FROM pg_statio_user_indexes
+		WHERE indexrelid = 'bench_uuids_pkey'::regclass"
+}
+
+setup_table()
+{
+	local expr
+	expr=$(generator_expr "$1" "$2")
+
+	$PSQL <<EOF
+DROP TABLE IF EXISTS bench_uuids;
+DROP SEQUENCE IF EXISTS bench_uuids_seq;
+CREATE SEQUENCE bench_uuids_seq;
+CREATE TABLE bench_uuids (id uuid PRIMARY KEY, payload text);
+INSERT INTO bench_uuids SELECT $expr, repeat('x', $PAYLOAD)
+  FROM generate_series(1, $PRELOAD);
+VACUUM ANALYZE bench_uuids;
+CHECKPOINT;
+EOF
+}
+
+echo "generator,block_size,block_count,clients,tps,wal_bytes,wal_fpi,index_bytes,index_hit_ratio,io_hit_ratio"
+
+for generator in $GENERATORS; do
+
+	# random UUIDs don't have a block size, so run them only once
+	if [ "$generator" = "random" ]; then
+		sizes=0
+	else
+		sizes=$BLOCK_SIZES
+	fi
+
+	for block_size in $sizes; do
+		for clients in $CLIENTS; do
+
+			setup_table "$generator" "$block_size"
+
+			IFS=',' read -r lsn_start fpi_start hits_start reads_start \
+				idx_hits_start idx_reads_start <<< "$(stats_snapshot)"
+
+			tps=$(pgbench -n -c "$clients" -j "$clients" -T "$DURATION" \
+						  -D block_size="$block_size" \
+						  -D block_count="$BLOCK_COUNT" \
+						  -D payload="$PAYLOAD" \
+						  -f "$BENCH_DIR/$generator.sql" 2>&1 |
+				  awk '/^tps = / {print $3; exit}')
+
+			# give the backends time to report the statistics
+			sleep 1
+
+			IFS=',' read -r lsn_end fpi_end hits_end reads_end \
+				idx_hits_end idx_reads_end <<< "$(stats_snapshot)"
+
+			result=$($PSQL -F ',' <<EOF
+SELECT pg_wal_lsn_diff('$lsn_end', '$lsn_start'),
+       fpi_end - fpi_start,
+       pg_relation_size('bench_uuids_pkey'),
+       round((idx_hits_end - idx_hits_start) /
+             NULLIF(idx_hits_end - idx_hits_start + idx_reads_end - idx_reads_start, 0), 4),
+       round((hits_end - hits_start) /
+             NULLIF(hits_end - hits_start + reads_end - reads_start, 0), 4)
+  FROM (VALUES (NULLIF('$fpi_start', '')::numeric, NULLIF('$fpi_end', '')::numeric,
+                NULLIF('$hits_start', '')::numeric, NULLIF('$hits_end', '')::numeric,
+                NULLIF('$reads_start', '')::numeric, NULLIF('$reads_end', '')::numeric,
+                NULLIF('$idx_hits_start', '')::numeric, NULLIF('$idx_hits_end', '')::numeric,
+                NULLIF('$idx_reads_start', '')::numeric, NULLIF('$idx_reads_end', '')::numeric))
+       AS s (fpi_start, fpi_end, hits_start, hits_end, reads_start, reads_end,
+             idx_hits_start, idx_hits_end, idx_reads_start, idx_reads_end)
+EOF
+)
+
+			echo "$generator,$block_size,$BLOCK_COUNT,$clients,$tps,$result"
+		done
+	done
+done
@@ -0,0 +1,2 @@
+-- sequence-based UUIDs
+INSERT INTO bench_uuids (id, payload) VALUES (uuid_sequence_nextval('bench_uuids_seq'::regclass, :block_size, :block_count), repeat('x', :payload));
@@ -0,0 +1,2 @@
+-- time-based UUIDs (block_size is the interval length in seconds)
+INSERT INTO bench_uuids (id, payload) VALUES (uuid_time_nextval(:block_size, :block_count), repeat('x', :payload));
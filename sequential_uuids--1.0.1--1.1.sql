@@ -0,0 +1,283 @@
+/* sequential_uuids--1.0.1--1.1.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION sequential_uuids UPDATE TO '1.1'" to load this file. \quit
+
+-- nextval is not allowed in parallel mode
+ALTER FUNCTION uuid_sequence_nextval(regclass, int, int) PARALLEL UNSAFE;
+
+CREATE FUNCTION uuid_sequence_nextval_bulk(regclass, n int, block_size int default 65536, block_count int default 65536) RETURNS SETOF uuid
+AS 'MODULE_PATHNAME', 'uuid_sequence_nextval_bulk'
+LANGUAGE C STRICT;
+
+CREATE FUNCTION uuid_sequence_nextval_array(regclass, n int, block_size int default 65536, block_count int default 65536) RETURNS uuid[]
+AS 'MODULE_PATHNAME', 'uuid_sequence_nextval_array'
+LANGUAGE C STRICT;
+
+CREATE FUNCTION uuid_time_nextval_series(n int, interval_length int default 60, interval_count int default 65536) RETURNS SETOF uuid
+AS 'MODULE_PATHNAME', 'uuid_time_nextval_series'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_nextval_array(n int, interval_length int default 60, interval_count int default 65536) RETURNS uuid[]
+AS 'MODULE_PATHNAME', 'uuid_time_nextval_array'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_nextval_ordered(interval_length int default 60, interval_count int default 65536, position_bytes int default 2) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_time_nextval_ordered'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_nextval_ms(interval_length int default 60000, interval_count int default 65536) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_time_nextval_ms'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_counter_nextval(name text, block_size int default 65536, block_count int default 65536) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_counter_nextval'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_counter_lease(name text, sequence regclass, n int) RETURNS bigint
+AS 'MODULE_PATHNAME', 'uuid_counter_lease'
+LANGUAGE C STRICT;
+
+CREATE FUNCTION uuid_time_block(id uuid, interval_length int default 60, interval_count int default 65536) RETURNS int
+AS 'MODULE_PATHNAME', 'uuid_time_block'
+LANGUAGE C STABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_sequence_block(id uuid, block_count int default 65536) RETURNS int
+AS 'MODULE_PATHNAME', 'uuid_sequence_block'
+LANGUAGE C STABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_block(id uuid, block_count int default 65536, node_id_bytes int default 0) RETURNS int
+AS 'MODULE_PATHNAME', 'uuid_block'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_block_ranges(block int, from_time timestamptz, to_time timestamptz, interval_length int default 60, interval_count int default 65536) RETURNS SETOF tstzrange
+AS 'MODULE_PATHNAME', 'uuid_time_block_ranges'
+LANGUAGE C STABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_block_bound(block int, block_count int default 65536) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_block_bound'
+LANGUAGE C STABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_lower_bound(ts timestamptz, interval_length int default 60, interval_count int default 65536) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_time_lower_bound'
+LANGUAGE C STABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_upper_bound(ts timestamptz, interval_length int default 60, interval_count int default 65536) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_time_upper_bound'
+LANGUAGE C STABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_ranges(from_time timestamptz, to_time timestamptz, interval_length int default 60, interval_count int default 65536, OUT lower uuid, OUT upper uuid) RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'uuid_time_ranges'
+LANGUAGE C STABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_within_support(internal) RETURNS internal
+AS 'MODULE_PATHNAME', 'uuid_time_within_support'
+LANGUAGE C STRICT;
+
+CREATE FUNCTION uuid_time_within(id uuid, from_time timestamptz, to_time timestamptz, interval_length int default 60, interval_count int default 65536) RETURNS boolean
+AS 'MODULE_PATHNAME', 'uuid_time_within'
+LANGUAGE C STABLE STRICT PARALLEL SAFE;
+
+-- planner support functions are available only on PostgreSQL 12+
+DO $$
+BEGIN
+    IF current_setting('server_version_num')::int >= 120000 THEN
+        EXECUTE 'ALTER FUNCTION uuid_time_within(uuid, timestamptz, timestamptz, int, int) SUPPORT uuid_time_within_support';
+    END IF;
+END;
+$$;
+
+CREATE FUNCTION uuid_block_partition_create(parent regclass, block int, blocks_per_partition int, block_count int default 65536) RETURNS regclass
+AS $$
+DECLARE
+    v_first     int := (block / blocks_per_partition) * blocks_per_partition;
+    v_last      int := least(v_first + blocks_per_partition, block_count);
+    v_schema    name;
+    v_name      name;
+    v_lower     text;
+    v_upper     text;
+BEGIN
+    IF blocks_per_partition < 1 THEN
+        RAISE EXCEPTION 'number of blocks per partition must be a positive integer';
+    END IF;
+
+    IF block < 0 OR block >= block_count THEN
+        RAISE EXCEPTION 'block ID must be between 0 and %', block_count - 1;
+    END IF;
+
+    SELECT n.nspname, c.relname INTO v_schema, v_name
+      FROM pg_class c JOIN pg_namespace n ON (n.oid = c.relnamespace)
+     WHERE c.oid = parent;
+
+    -- zero-padded first block ID, so that partitions sort by name
+    v_name := format('%s_p%s', v_name,
+                     lpad(v_first::text, length((block_count - 1)::text), '0'));
+
+    IF to_regclass(format('%I.%I', v_schema, v_name)) IS NOT NULL THEN
+        RETURN to_regclass(format('%I.%I', v_schema, v_name));
+    END IF;
+
+    v_lower := quote_literal(uuid_block_bound(v_first, block_count));
+
+    -- the last partition covers everything up to the end of the key space
+    IF v_last = block_count THEN
+        v_upper := 'MAXVALUE';
+    ELSE
+        v_upper := quote_literal(uuid_block_bound(v_last, block_count));
+    END IF;
+
+    EXECUTE format('CREATE TABLE %I.%I PARTITION OF %s FOR VALUES FROM (%s) TO (%s)',
+                   v_schema, v_name, parent, v_lower, v_upper);
+
+    RETURN to_regclass(format('%I.%I', v_schema, v_name));
+END;
+$$ LANGUAGE plpgsql STRICT;
+
+CREATE FUNCTION uuid_time_partitions_roll(parent regclass, retention interval, premake int default 1, blocks_per_partition int default 60, interval_length int default 60, interval_count int default 65536, detach_only boolean default false) RETURNS void
+AS $$
+DECLARE
+    v_now       timestamptz := now();
+    v_first     bigint;
+    v_last      bigint;
+    v_interval  bigint;
+    v_block     int;
+    v_keep      regclass[] := '{}';
+    v_prefix    text := (SELECT relname FROM pg_class WHERE oid = parent) || '_p';
+    v_part      record;
+BEGIN
+    IF blocks_per_partition < 1 OR premake < 0 THEN
+        RAISE EXCEPTION 'invalid partitioning parameters';
+    END IF;
+
+    -- intervals (since Unix epoch) with data we need to keep or expect soon
+    v_first := floor(extract(epoch FROM v_now - retention) / interval_length);
+    v_last := floor(extract(epoch FROM v_now) / interval_length) +
+              premake::bigint * blocks_per_partition;
+
+    IF v_last - v_first + 1 > interval_count - blocks_per_partition THEN
+        RAISE EXCEPTION 'retention period is too long for the UUID wrap-around cycle';
+    END IF;
+
+    -- make sure the partitions exist, jumping from one partition to the next
+    v_interval := v_first;
+    WHILE v_interval <= v_last LOOP
+        v_block := v_interval % interval_count;
+
+        v_keep := v_keep || uuid_block_partition_create(parent, v_block, blocks_per_partition, interval_count);
+
+        v_interval := v_interval +
+                      least((v_block / blocks_per_partition + 1) * blocks_per_partition,
+                            interval_count) - v_block;
+    END LOOP;
+
+    -- get rid of partitions created by us and not needed anymore
+    FOR v_part IN SELECT i.inhrelid::regclass AS part
+                    FROM pg_inherits i JOIN pg_class c ON (c.oid = i.inhrelid)
+                   WHERE i.inhparent = parent
+                     AND left(c.relname, length(v_prefix)) = v_prefix
+                     AND substr(c.relname, length(v_prefix) + 1) ~ '^[0-9]+$'
+                     AND NOT (i.inhrelid::regclass = ANY (v_keep))
+    LOOP
+        IF detach_only THEN
+            EXECUTE format('ALTER TABLE %s DETACH PARTITION %s', parent, v_part.part);
+        ELSE
+            EXECUTE format('DROP TABLE %s', v_part.part);
+        END IF;
+    END LOOP;
+END;
+$$ LANGUAGE plpgsql STRICT;
+
+CREATE FUNCTION uuid_adaptive_nextval(name text, block_target int default 65536, max_interval int default 60, block_count int default 65536) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_adaptive_nextval'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_adaptive_state(name text, OUT block bigint, OUT block_uuids bigint, OUT block_start timestamptz, OUT rate float8) RETURNS record
+AS 'MODULE_PATHNAME', 'uuid_adaptive_state'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_adaptive_skip_dense(name text, index regclass, max_fill float8 default 0.5, block_count int default 65536) RETURNS int
+AS 'MODULE_PATHNAME', 'uuid_adaptive_skip_dense'
+LANGUAGE C STRICT;
+
+CREATE TABLE uuid_generators (
+    name            text PRIMARY KEY,
+    kind            text NOT NULL CHECK (kind IN ('sequence', 'time', 'time_ms', 'counter', 'adaptive')),
+    block_size      int NOT NULL DEFAULT 65536,
+    block_count     int NOT NULL DEFAULT 65536,
+    sequence        text CHECK ((kind = 'sequence') = (sequence IS NOT NULL)),
+    position_bytes  int NOT NULL DEFAULT 0,
+    max_interval    int NOT NULL DEFAULT 60
+);
+
+SELECT pg_catalog.pg_extension_config_dump('uuid_generators', '');
+
+-- named generators may be used by any role, so everyone can read the definitions
+GRANT SELECT ON uuid_generators TO PUBLIC;
+
+CREATE FUNCTION uuid_generators_invalidate() RETURNS trigger
+AS 'MODULE_PATHNAME', 'uuid_generators_invalidate'
+LANGUAGE C;
+
+CREATE TRIGGER uuid_generators_invalidate
+    AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON uuid_generators
+    FOR EACH STATEMENT EXECUTE PROCEDURE uuid_generators_invalidate();
+
+CREATE FUNCTION uuid_create_generator(name text, kind text, block_size int default 65536, block_count int default 65536, sequence regclass default null, position_bytes int default 0, max_interval int default 60) RETURNS void
+AS 'MODULE_PATHNAME', 'uuid_create_generator'
+LANGUAGE C;
+
+CREATE FUNCTION uuid_drop_generator(name text) RETURNS boolean
+AS 'MODULE_PATHNAME', 'uuid_drop_generator'
+LANGUAGE C STRICT;
+
+CREATE FUNCTION uuid_generate(name text) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_generate'
+LANGUAGE C STRICT;
+
+CREATE FUNCTION sequential_uuids_stats(OUT kind text, OUT sequence regclass, OUT counter text, OUT block_size int, OUT block_count int, OUT calls bigint, OUT uuids bigint, OUT random_bytes bigint, OUT nextval_avoided bigint, OUT block_transitions bigint, OUT wraparounds bigint, OUT random_time float8, OUT version int) RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'sequential_uuids_stats'
+LANGUAGE C STRICT PARALLEL RESTRICTED;
+
+CREATE VIEW sequential_uuids_stats AS SELECT * FROM sequential_uuids_stats();
+
+CREATE FUNCTION sequential_uuids_stats_reset() RETURNS void
+AS 'MODULE_PATHNAME', 'sequential_uuids_stats_reset'
+LANGUAGE C PARALLEL RESTRICTED;
+
+REVOKE ALL ON FUNCTION sequential_uuids_stats_reset() FROM PUBLIC;
+
+CREATE FUNCTION sequential_uuids_bench(kind text, n int, block_size int default 65536, block_count int default 65536, sequence regclass default null, batch_size int default 0, OUT prepare_ns float8, OUT prepare_uncached_ns float8, OUT clock_ns float8, OUT sequence_ns float8, OUT random_ns float8, OUT layout_ns float8, OUT alloc_ns float8, OUT total_ns float8) RETURNS record
+AS 'MODULE_PATHNAME', 'sequential_uuids_bench'
+LANGUAGE C;
+
+CREATE FUNCTION sequential_uuids_recommend(index regclass, cache_size bigint, rate float8, OUT leaf_pages bigint, OUT tuples_per_leaf float8, OUT block_size int, OUT interval_length int, OUT block_count int, OUT cycle_uuids bigint, OUT wraparound interval) RETURNS record
+AS 'MODULE_PATHNAME', 'sequential_uuids_recommend'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_nextval_v7() RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_time_nextval_v7'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_time_nextval_v8(interval_length int default 60, interval_count int default 65536) RETURNS uuid
+AS 'MODULE_PATHNAME', 'uuid_time_nextval_v8'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_sequence_nextval_packed(regclass, n int, block_size int default 65536, block_count int default 65536) RETURNS bytea
+AS 'MODULE_PATHNAME', 'uuid_sequence_nextval_packed'
+LANGUAGE C STRICT;
+
+CREATE FUNCTION uuid_time_nextval_packed(n int, interval_length int default 60, interval_count int default 65536) RETURNS bytea
+AS 'MODULE_PATHNAME', 'uuid_time_nextval_packed'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_pack(uuid[]) RETURNS bytea
+AS 'MODULE_PATHNAME', 'uuid_pack'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_unpack(bytea) RETURNS SETOF uuid
+AS 'MODULE_PATHNAME', 'uuid_unpack'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION uuid_unpack_array(bytea) RETURNS uuid[]
+AS 'MODULE_PATHNAME', 'uuid_unpack_array'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
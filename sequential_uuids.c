@@ -17,183 +17,5476 @@
  */
 #include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "postgres.h"
 
+#include "access/genam.h"
+#include "access/htup_details.h"
+#include "access/nbtree.h"
+#include "access/parallel.h"
+#if PG_VERSION_NUM >= 120000
+#include "access/relation.h"
+#else
+#include "access/heapam.h"
+#endif
+#include "access/stratnum.h"
+#include "access/xact.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_sequence.h"
+#include "catalog/pg_type.h"
 #include "commands/sequence.h"
+#include "commands/trigger.h"
+#include "datatype/timestamp.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#if PG_VERSION_NUM >= 120000
+#include "nodes/supportnodes.h"
+#endif
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "portability/instr_time.h"
+#include "postmaster/bgworker.h"
+#include "executor/spi.h"
+#include "storage/bufmgr.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lmgr.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"
+#include "utils/acl.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rangetypes.h"
+#include "utils/regproc.h"
+#include "utils/rel.h"
+#include "utils/snapmgr.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
+#include "utils/typcache.h"
 #include "utils/uuid.h"
+#include "utils/varlena.h"
+
+#include "sequential_uuids.h"
+
+/*
+ * On x86-64 we use SSE2 (always available there) and AVX2 (if supported
+ * by the CPU) to apply the UUID layout in batches. Other platforms use
+ * the plain C implementation.
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define USE_X86_LAYOUT_KERNELS
+#include <immintrin.h>
+#endif
 
 PG_MODULE_MAGIC;
 
-PG_FUNCTION_INFO_V1(uuid_sequence_nextval);
-PG_FUNCTION_INFO_V1(uuid_time_nextval);
+/*
+ * Size of the per-backend pool of random bytes. The pool is refilled by a
+ * single pg_strong_random() call, so with the default parameters (14 random
+ * bytes per UUID) each refill is amortized over ~290 UUIDs.
+ */
+#define RANDOM_POOL_SIZE	4096
+
+/* maximum amount of random data requested by a single pg_strong_random call */
+#define RANDOM_CHUNK_SIZE	(1024 * 1024)
+
+static unsigned char random_pool[RANDOM_POOL_SIZE];
+static int		random_pool_offset = RANDOM_POOL_SIZE;	/* empty */
+static int		random_pool_pid = 0;
+
+/* number of bytes produced by the fast generator before reseeding */
+#define RANDOM_FAST_RESEED	(1024 * 1024)
+
+/*
+ * State of the fast (non-cryptographic) generator, xoshiro256**. Seeded
+ * from pg_strong_random(), and reseeded after fork and periodically.
+ */
+static uint64	random_fast_state[4];
+static size_t	random_fast_remaining = 0;	/* needs seeding */
+static int		random_fast_pid = 0;
+
+/*
+ * State of the seeded (deterministic) generator, also xoshiro256**, but
+ * seeded from sequential_uuids.random_seed and never reseeded. Restarted
+ * whenever the seed (or the random source) is set.
+ */
+static uint64	random_seeded_state[4];
+static bool		random_seeded_valid = false;	/* needs seeding */
+
+/* number of reads of the virtual clock since it was (re)started */
+static int64	virtual_clock_reads = 0;
+static bool		virtual_clock_valid = false;	/* needs restart */
+
+/*
+ * Range of sequence values prefetched by the backend (for one sequence).
+ */
+typedef struct SequencePrefetch
+{
+	Oid			relid;			/* hash key (must be first) */
+	int64		next;			/* next value to hand out */
+	int64		increment;		/* sequence increment */
+	int64		remaining;		/* number of values left in the range */
+	int64		backoff;		/* nextval calls before the next attempt */
+} SequencePrefetch;
+
+static HTAB	   *prefetch_hash = NULL;
+
+/* maximum number of blocks tracked by the dense block map */
+#define SKIP_MAP_BLOCKS		65536
+
+/*
+ * Counter in shared memory, used by counter-based generators.
+ */
+typedef struct SharedCounter
+{
+	char				name[NAMEDATALEN];
+	pg_atomic_uint64	value;
+	int64				limit;		/* end of leased range (PG_INT64_MAX if
+									 * not leased), set at creation */
+
+	/* state of adaptive generators (value is the block number) */
+	slock_t				mutex;			/* protects the fields below */
+	int64				block_uuids;	/* UUIDs generated in current block */
+	int64				block_start;	/* start of current block (usec) */
+	double				rate;			/* UUIDs per second (smoothed) */
+
+	/* dense blocks skipped by adaptive generators (uuid_adaptive_skip_dense) */
+	int32				skip_blocks;	/* block_count of the map (0 = none) */
+	int32				skip_count;		/* number of blocks to skip */
+	uint8				skip_map[SKIP_MAP_BLOCKS / 8];
+} SharedCounter;
+
+/*
+ * Shared state (shared memory segment).
+ */
+typedef struct SharedState
+{
+	LWLock		   *lock;		/* protects adding counters and stats */
+	int				ncounters;	/* number of used counters */
+	SharedCounter	counters[FLEXIBLE_ARRAY_MEMBER];
+} SharedState;
+
+/* counters are persisted in this file during shutdown */
+#define COUNTERS_DUMP_FILE	PGSTAT_STAT_PERMANENT_DIRECTORY "/sequential_uuids.stat"
+
+/* magic number identifying the file format (the old one has no limits) */
+static const uint32 COUNTERS_FILE_HEADER = 0x53554302;
+static const uint32 COUNTERS_FILE_HEADER_V1 = 0x53554301;
+
+static SharedState *shared = NULL;
+
+/*
+ * Statistics are tracked per generator configuration (kind, sequence or
+ * counter, block size and count). The key is compared as a whole, so it
+ * has to be zeroed before filling it.
+ */
+typedef struct StatsKey
+{
+	int32		kind;			/* GeneratorKind */
+	Oid			relid;			/* sequence (GENERATOR_SEQUENCE only) */
+	char		counter_name[NAMEDATALEN];	/* GENERATOR_COUNTER/ADAPTIVE */
+	int32		block_size;
+	int32		block_count;
+	int32		interval_unit;	/* GENERATOR_TIME only */
+	int32		version;		/* UUID version */
+} StatsKey;
+
+typedef struct StatsCounters
+{
+	int64		calls;				/* calls generating UUIDs */
+	int64		uuids;				/* UUIDs generated */
+	int64		random_bytes;		/* random bytes requested */
+	int64		nextval_avoided;	/* nextval calls avoided by prefetching */
+	int64		block_transitions;	/* switches to a different block */
+	int64		wraparounds;		/* block ID wrapped around to 0 */
+	double		random_time;		/* time generating random data (ms) */
+} StatsCounters;
+
+/*
+ * Statistics entry in shared memory. The hash table is protected by the
+ * lock in SharedState (exclusive lock is needed to add or remove entries),
+ * the counters by the spinlock.
+ */
+typedef struct SharedStatsEntry
+{
+	StatsKey		key;		/* hash key (must be first) */
+	slock_t			mutex;		/* protects the counters */
+	StatsCounters	counters;
+} SharedStatsEntry;
+
+/*
+ * Backend-local statistics, accumulated and added to the shared entry at
+ * the end of each transaction (so that generating UUIDs does not need to
+ * touch shared memory).
+ */
+typedef struct LocalStatsEntry
+{
+	StatsKey		key;		/* hash key (must be first) */
+	StatsCounters	counters;
+} LocalStatsEntry;
+
+static HTAB	   *shared_stats_hash = NULL;
+static HTAB	   *local_stats_hash = NULL;
+static bool		local_stats_pending = false;
+
+#if PG_VERSION_NUM >= 150000
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+#endif
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+typedef enum GeneratorKind
+{
+	GENERATOR_SEQUENCE,			/* block ID derived from a sequence */
+	GENERATOR_TIME,				/* block ID derived from current time */
+	GENERATOR_COUNTER,			/* block ID derived from a shared counter */
+	GENERATOR_ADAPTIVE			/* block advanced by count or time */
+} GeneratorKind;
+
+/*
+ * Parameters of a generator. A prepared generator is reused only when
+ * called with exactly the same parameters, and the struct is compared as
+ * a whole, so it has to be zeroed before filling it.
+ *
+ * For time-based generators, block_size/block_count are the interval
+ * length (in interval_unit) and number of intervals. For adaptive
+ * generators, block_size is the target number of UUIDs per block.
+ */
+typedef struct GeneratorParams
+{
+	GeneratorKind	kind;
+	Oid				relid;			/* sequence (GENERATOR_SEQUENCE only) */
+	char			counter_name[NAMEDATALEN];	/* GENERATOR_COUNTER/ADAPTIVE */
+	int32			block_size;
+	int32			block_count;
+	int32			interval_unit;	/* microseconds (GENERATOR_TIME only) */
+	int32			max_interval;	/* seconds (GENERATOR_ADAPTIVE only) */
+	int32			position_bytes;	/* bytes encoding position in block */
+	int32			node_id;		/* node ID (-1 means no node ID) */
+	int32			node_bytes;		/* bytes encoding node ID */
+	bool			node_first;		/* node ID placed before block ID */
+	int32			stripes;		/* number of stripes (1 means no stripes) */
+	int32			version;		/* UUID version (4, 7 or 8) */
+} GeneratorParams;
+
+/*
+ * Generator prepared for repeated calls with the same parameters.
+ *
+ * The layout of the UUID (see sequential_uuids.h) is shared with client
+ * applications, the layout fields have to fit into the bits before the
+ * UUID version (that is into UUID_LAYOUT_BITS). The stripe in the layout
+ * is the stripe assigned to this backend.
+ */
+typedef struct SeqUUIDGenerator
+{
+	GeneratorParams	params;
+
+	SharedCounter  *counter;		/* GENERATOR_COUNTER/ADAPTIVE */
+
+	SeqUUIDLayout	layout;			/* layout of the UUID */
+
+	pg_uuid_t		random_mask;	/* bits filled with random data */
+
+	LocalStatsEntry *stats;			/* NULL if not tracked */
+	int64			last_block;		/* block of the last UUID (not wrapped) */
+} SeqUUIDGenerator;
+
+/*
+ * Kernel applying the layout to a run of UUIDs filled with random data,
+ * i.e. computing (uuid & mask) | bits for each of them. The mask keeps
+ * the random bits, and bits are the layout fields and version flags.
+ * The implementation is chosen when the module is loaded.
+ */
+typedef void (*uuid_apply_layout_fn) (pg_uuid_t *uuids, int nvalues,
+									  const pg_uuid_t *mask,
+									  const pg_uuid_t *bits);
+
+static void uuid_apply_layout_scalar(pg_uuid_t *uuids, int nvalues,
+									 const pg_uuid_t *mask,
+									 const pg_uuid_t *bits);
+
+static uuid_apply_layout_fn uuid_apply_layout = uuid_apply_layout_scalar;
+
+/* number of leading bits available for the layout (before UUID version) */
+#define UUID_LAYOUT_BITS	SQUUID_LAYOUT_BITS
+
+/*
+ * Source of current time for time-based generators.
+ */
+typedef enum ClockSource
+{
+	CLOCK_SOURCE_REALTIME,		/* gettimeofday() */
+	CLOCK_SOURCE_COARSE,		/* clock_gettime(CLOCK_REALTIME_COARSE) */
+	CLOCK_SOURCE_STATEMENT,		/* statement start timestamp */
+	CLOCK_SOURCE_TRANSACTION,	/* transaction start timestamp */
+	CLOCK_SOURCE_VIRTUAL		/* virtual clock (deterministic) */
+} ClockSource;
+
+static const struct config_enum_entry clock_source_options[] = {
+	{"realtime", CLOCK_SOURCE_REALTIME, false},
+	{"realtime_coarse", CLOCK_SOURCE_COARSE, false},
+	{"statement", CLOCK_SOURCE_STATEMENT, false},
+	{"transaction", CLOCK_SOURCE_TRANSACTION, false},
+	{"virtual", CLOCK_SOURCE_VIRTUAL, false},
+	{NULL, 0, false}
+};
+
+/*
+ * Source of random data for the random part of the UUIDs.
+ */
+typedef enum RandomSource
+{
+	RANDOM_SOURCE_STRONG,		/* pg_strong_random() */
+	RANDOM_SOURCE_FAST,			/* xoshiro256**, seeded by pg_strong_random() */
+	RANDOM_SOURCE_SEEDED		/* xoshiro256**, seeded by random_seed */
+} RandomSource;
+
+static const struct config_enum_entry random_source_options[] = {
+	{"strong", RANDOM_SOURCE_STRONG, false},
+	{"fast", RANDOM_SOURCE_FAST, false},
+	{"seeded", RANDOM_SOURCE_SEEDED, false},
+	{NULL, 0, false}
+};
+
+/* stripe assigned to a backend */
+#if PG_VERSION_NUM >= 170000
+#define BackendStripeNumber(stripes)	(MyProcNumber % (stripes))
+#else
+#define BackendStripeNumber(stripes)	(MyProc->pgprocno % (stripes))
+#endif
+
+/* default stream of the seeded random source (same for parallel workers) */
+#if PG_VERSION_NUM >= 170000
+#define BackendRandomStream() \
+	(IsParallelWorker() ? ParallelLeaderProcNumber : MyProcNumber)
+#elif PG_VERSION_NUM >= 140000
+#define BackendRandomStream() \
+	(IsParallelWorker() ? ParallelLeaderBackendId : MyBackendId)
+#else
+#define BackendRandomStream() \
+	(IsParallelWorker() ? ParallelMasterBackendId : MyBackendId)
+#endif
+
+/* is the lock held by this backend (PG17 added the orstronger argument) */
+#if PG_VERSION_NUM >= 170000
+#define LockHeldByMeCompat(tag, mode)	LockHeldByMe((tag), (mode), false)
+#else
+#define LockHeldByMeCompat(tag, mode)	LockHeldByMe((tag), (mode))
+#endif
+
+/*
+ * Named generator, with parameters loaded from the uuid_generators table
+ * and cached in backend memory. The cached entries are invalidated when
+ * the table gets modified (by a trigger sending a relcache invalidation).
+ */
+typedef struct NamedGenerator
+{
+	char				name[NAMEDATALEN];	/* hash key (must be first) */
+	bool				valid;		/* params loaded and up to date */
+	bool				prepared;	/* gen prepared (for current params) */
+	GeneratorParams		params;		/* parameters from the table */
+	SeqUUIDGenerator	gen;		/* prepared generator */
+} NamedGenerator;
+
+static HTAB	   *generators_hash = NULL;
+static Oid		generators_relid = InvalidOid;
+
+/* GUC variables */
+static int		sequence_prefetch = 1;
+static int		clock_source = CLOCK_SOURCE_REALTIME;
+static int		random_source = RANDOM_SOURCE_STRONG;
+static int		random_seed = 0;
+static int		random_stream = -1;
+static int		virtual_clock_start = 946684800;	/* 2000-01-01 */
+static double	virtual_clock_rate = 1000.0;
+static int		node_id = -1;
+static int		node_id_bytes = 1;
+static bool		node_id_first = false;
+static int		max_counters = 64;
+static int		max_stats = 256;
+static bool		track_random_timing = false;
+static int		stripes = 1;
+static char	   *prewarm_database = NULL;
+static char	   *prewarm_indexes = NULL;
+static int		prewarm_interval_length = 60;
+static int		prewarm_interval_count = 65536;
+static int		prewarm_lead_time = 5;
+
+/* flags set by signal handlers of the prewarm worker */
+static volatile sig_atomic_t got_sighup = false;
+
+void		_PG_init(void);
+
+PGDLLEXPORT void sequential_uuids_prewarm_main(Datum main_arg);
+
+static void sequential_uuids_shmem_startup(void);
+#if PG_VERSION_NUM >= 150000
+static void sequential_uuids_shmem_request(void);
+#endif
+static Size shared_state_size(void);
+static void random_seeded_reset(int newval, void *extra);
+static void virtual_clock_reset(int newval, void *extra);
+static void virtual_clock_rate_reset(double newval, void *extra);
+static Size shared_memory_size(void);
+static uuid_apply_layout_fn uuid_apply_layout_choose(void);
+static void counters_load(void);
+static void counters_shmem_shutdown(int code, Datum arg);
+
+PG_FUNCTION_INFO_V1(uuid_sequence_nextval);
+PG_FUNCTION_INFO_V1(uuid_time_nextval);
+PG_FUNCTION_INFO_V1(uuid_sequence_nextval_bulk);
+PG_FUNCTION_INFO_V1(uuid_sequence_nextval_array);
+PG_FUNCTION_INFO_V1(uuid_time_nextval_series);
+PG_FUNCTION_INFO_V1(uuid_time_nextval_array);
+PG_FUNCTION_INFO_V1(uuid_sequence_nextval_packed);
+PG_FUNCTION_INFO_V1(uuid_time_nextval_packed);
+PG_FUNCTION_INFO_V1(uuid_pack);
+PG_FUNCTION_INFO_V1(uuid_unpack);
+PG_FUNCTION_INFO_V1(uuid_unpack_array);
+PG_FUNCTION_INFO_V1(uuid_time_nextval_ordered);
+PG_FUNCTION_INFO_V1(uuid_time_nextval_ms);
+PG_FUNCTION_INFO_V1(uuid_time_nextval_v7);
+PG_FUNCTION_INFO_V1(uuid_time_nextval_v8);
+PG_FUNCTION_INFO_V1(uuid_counter_nextval);
+PG_FUNCTION_INFO_V1(uuid_counter_lease);
+PG_FUNCTION_INFO_V1(uuid_adaptive_nextval);
+PG_FUNCTION_INFO_V1(uuid_adaptive_state);
+PG_FUNCTION_INFO_V1(uuid_adaptive_skip_dense);
+PG_FUNCTION_INFO_V1(uuid_create_generator);
+PG_FUNCTION_INFO_V1(uuid_drop_generator);
+PG_FUNCTION_INFO_V1(uuid_generate);
+PG_FUNCTION_INFO_V1(uuid_generators_invalidate);
+PG_FUNCTION_INFO_V1(uuid_time_block);
+PG_FUNCTION_INFO_V1(uuid_sequence_block);
+PG_FUNCTION_INFO_V1(uuid_block);
+PG_FUNCTION_INFO_V1(uuid_time_block_ranges);
+PG_FUNCTION_INFO_V1(uuid_block_bound);
+PG_FUNCTION_INFO_V1(uuid_time_lower_bound);
+PG_FUNCTION_INFO_V1(uuid_time_upper_bound);
+PG_FUNCTION_INFO_V1(uuid_time_ranges);
+PG_FUNCTION_INFO_V1(uuid_time_within);
+PG_FUNCTION_INFO_V1(uuid_time_within_support);
+PG_FUNCTION_INFO_V1(sequential_uuids_stats);
+PG_FUNCTION_INFO_V1(sequential_uuids_stats_reset);
+PG_FUNCTION_INFO_V1(sequential_uuids_bench);
+PG_FUNCTION_INFO_V1(sequential_uuids_recommend);
+
+/*
+ * Module load callback
+ */
+void
+_PG_init(void)
+{
+	DefineCustomIntVariable("sequential_uuids.sequence_prefetch",
+							"Number of sequence values prefetched by uuid_sequence_nextval.",
+							"Values are reserved from the sequence in ranges of this size, "
+							"and then handed out locally by the backend. The value 1 means "
+							"values are fetched from the sequence one by one.",
+							&sequence_prefetch,
+							1,
+							1, INT_MAX,
+							PGC_USERSET,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.node_id",
+							"Node ID included in generated UUIDs.",
+							"When set, the node ID is included in the UUID, so that "
+							"each node generating UUIDs has a separate insert point "
+							"in indexes. The value -1 means no node ID.",
+							&node_id,
+							-1,
+							-1, 65535,
+							PGC_SUSET,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.node_id_bytes",
+							"Number of bytes used to store the node ID.",
+							NULL,
+							&node_id_bytes,
+							1,
+							1, 2,
+							PGC_SUSET,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomBoolVariable("sequential_uuids.node_id_first",
+							 "Place the node ID before the block ID.",
+							 "By default the node ID is placed right after the block "
+							 "ID, so that all nodes share the same block ID range.",
+							 &node_id_first,
+							 false,
+							 PGC_SUSET,
+							 0,
+							 NULL, NULL, NULL);
+
+	DefineCustomEnumVariable("sequential_uuids.clock_source",
+							 "Source of current time for time-based generators.",
+							 "The statement and transaction sources use the start "
+							 "timestamp of the statement or transaction, so the clock "
+							 "is not read for each UUID, and all UUIDs generated by "
+							 "the statement (or transaction) share the same block.",
+							 &clock_source,
+							 CLOCK_SOURCE_REALTIME,
+							 clock_source_options,
+							 PGC_USERSET,
+							 0,
+							 NULL, virtual_clock_reset, NULL);
+
+	DefineCustomEnumVariable("sequential_uuids.random_source",
+							 "Source of random data for generated UUIDs.",
+							 "The fast source is a non-cryptographic generator seeded "
+							 "from the strong one. It's much cheaper, but the UUIDs "
+							 "are predictable, so use it only when that's acceptable.",
+							 &random_source,
+							 RANDOM_SOURCE_STRONG,
+							 random_source_options,
+							 PGC_USERSET,
+							 0,
+							 NULL, random_seeded_reset, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.random_seed",
+							"Seed of the seeded random source (unsafe, for testing only).",
+							"With sequential_uuids.random_source set to seeded, the "
+							"random data is a deterministic stream determined by the "
+							"seed, restarted whenever the seed is set.",
+							&random_seed,
+							0,
+							0, INT_MAX,
+							PGC_USERSET,
+							0,
+							NULL, random_seeded_reset, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.random_stream",
+							"Stream of the seeded random source (unsafe, for testing only).",
+							"Sessions using different streams (with the same seed) "
+							"get non-overlapping random data. The value -1 means "
+							"the stream is determined by the backend process number.",
+							&random_stream,
+							-1,
+							-1, 65535,
+							PGC_USERSET,
+							0,
+							NULL, random_seeded_reset, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.virtual_clock_start",
+							"Start of the virtual clock (unsafe, for testing only).",
+							"Number of seconds since the Unix epoch. The virtual "
+							"clock is restarted whenever this is set.",
+							&virtual_clock_start,
+							946684800,
+							0, INT_MAX,
+							PGC_USERSET,
+							0,
+							NULL, virtual_clock_reset, NULL);
+
+	DefineCustomRealVariable("sequential_uuids.virtual_clock_rate",
+							 "Number of reads per second of the virtual clock.",
+							 "Each read advances the virtual clock by 1/rate seconds.",
+							 &virtual_clock_rate,
+							 1000.0,
+							 0.001, 1e9,
+							 PGC_USERSET,
+							 0,
+							 NULL, virtual_clock_rate_reset, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.stripes",
+							"Number of stripes (insert points) within a block.",
+							"Each backend is assigned one of the stripes, stored "
+							"right after the block ID, so that concurrent sessions "
+							"insert into different parts of the block's key range. "
+							"The value 1 means no stripes.",
+							&stripes,
+							1,
+							1, 256,
+							PGC_USERSET,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.max_counters",
+							"Maximum number of shared counters.",
+							"Counters are used by uuid_counter_nextval, and are "
+							"kept in shared memory.",
+							&max_counters,
+							64,
+							1, 65536,
+							PGC_POSTMASTER,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.max_stats",
+							"Maximum number of generators tracked in statistics.",
+							"Statistics are kept in shared memory, for each generator "
+							"configuration. Generators not fitting into the limit "
+							"are not tracked.",
+							&max_stats,
+							256,
+							1, 65536,
+							PGC_POSTMASTER,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomBoolVariable("sequential_uuids.track_random_timing",
+							 "Collect timing of random data generation.",
+							 "Reading the clock may be expensive on some platforms, "
+							 "so this is disabled by default.",
+							 &track_random_timing,
+							 false,
+							 PGC_SUSET,
+							 0,
+							 NULL, NULL, NULL);
+
+	DefineCustomStringVariable("sequential_uuids.prewarm_database",
+							   "Database the index prewarm worker connects to.",
+							   "When set, a background worker prewarms the indexes "
+							   "listed in sequential_uuids.prewarm_indexes shortly "
+							   "before time-based generators switch to the next block.",
+							   &prewarm_database,
+							   NULL,
+							   PGC_POSTMASTER,
+							   0,
+							   NULL, NULL, NULL);
+
+	DefineCustomStringVariable("sequential_uuids.prewarm_indexes",
+							   "Comma-separated list of indexes to prewarm.",
+							   "B-tree indexes with an UUID generated by a time-based "
+							   "generator as the first key column.",
+							   &prewarm_indexes,
+							   "",
+							   PGC_SIGHUP,
+							   GUC_LIST_INPUT,
+							   NULL, NULL, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.prewarm_interval_length",
+							"Interval length of the generator used by prewarmed indexes.",
+							NULL,
+							&prewarm_interval_length,
+							60,
+							1, INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL, NULL, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.prewarm_interval_count",
+							"Number of intervals of the generator used by prewarmed indexes.",
+							NULL,
+							&prewarm_interval_count,
+							65536,
+							1, INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomIntVariable("sequential_uuids.prewarm_lead_time",
+							"How long before the next block starts to prewarm it.",
+							NULL,
+							&prewarm_lead_time,
+							5,
+							0, 3600,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL, NULL, NULL);
+
+#if PG_VERSION_NUM >= 150000
+	MarkGUCPrefixReserved("sequential_uuids");
+#else
+	EmitWarningsOnPlaceholders("sequential_uuids");
+#endif
+
+	uuid_apply_layout = uuid_apply_layout_choose();
+
+	/*
+	 * The shared memory (needed by counter-based generators) is available
+	 * only when loaded through shared_preload_libraries.
+	 */
+	if (!process_shared_preload_libraries_in_progress)
+		return;
+
+#if PG_VERSION_NUM >= 150000
+	prev_shmem_request_hook = shmem_request_hook;
+	shmem_request_hook = sequential_uuids_shmem_request;
+#else
+	RequestAddinShmemSpace(shared_memory_size());
+	RequestNamedLWLockTranche("sequential_uuids", 1);
+#endif
+
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = sequential_uuids_shmem_startup;
+
+	/* start the prewarm worker, if requested */
+	if (prewarm_database != NULL && prewarm_database[0] != '\0')
+	{
+		BackgroundWorker	worker;
+
+		memset(&worker, 0, sizeof(BackgroundWorker));
+
+		worker.bgw_flags = BGWORKER_SHMEM_ACCESS |
+			BGWORKER_BACKEND_DATABASE_CONNECTION;
+		worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+		worker.bgw_restart_time = 10;
+
+		snprintf(worker.bgw_library_name, sizeof(worker.bgw_library_name),
+				 "sequential_uuids");
+		snprintf(worker.bgw_function_name, sizeof(worker.bgw_function_name),
+				 "sequential_uuids_prewarm_main");
+		snprintf(worker.bgw_name, sizeof(worker.bgw_name),
+				 "sequential_uuids prewarm");
+#if PG_VERSION_NUM >= 110000
+		snprintf(worker.bgw_type, sizeof(worker.bgw_type),
+				 "sequential_uuids prewarm");
+#endif
+
+		RegisterBackgroundWorker(&worker);
+	}
+}
+
+/*
+ * random_pool_reset
+ *	discard all random bytes buffered by this backend
+ *
+ * The unused part of the pool is wiped, so that the bytes can't be handed
+ * out later (e.g. by a forked child process).
+ */
+static void
+random_pool_reset(void)
+{
+	memset(random_pool, 0, RANDOM_POOL_SIZE);
+	random_pool_offset = RANDOM_POOL_SIZE;
+	random_pool_pid = MyProcPid;
+}
+
+/*
+ * random_strong_fill
+ *	fill the buffer with random bytes directly from the strong generator
+ */
+static void
+random_strong_fill(unsigned char *buf, size_t len)
+{
+	while (len > 0)
+	{
+		size_t	nbytes = Min(len, RANDOM_CHUNK_SIZE);
+
+		if (!pg_strong_random(buf, nbytes))
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("could not generate random values")));
+
+		buf += nbytes;
+		len -= nbytes;
+	}
+}
+
+/*
+ * random_pool_fill
+ *	fill the buffer with random bytes from the backend-local pool
+ *
+ * Calling pg_strong_random() for each UUID is fairly expensive (it means
+ * a RAND_bytes call or reading /dev/urandom), so we fetch random data in
+ * larger chunks and then hand them out in small pieces. Bytes are wiped
+ * from the pool as soon as they are consumed.
+ *
+ * If the process forked since the pool was filled, the inherited pool is
+ * discarded first, so that two processes never use the same random bytes.
+ * Requests larger than the pool bypass it entirely.
+ */
+static void
+random_pool_fill(unsigned char *buf, size_t len)
+{
+	if (random_pool_pid != MyProcPid)
+		random_pool_reset();
+
+	while (len > 0)
+	{
+		size_t	nbytes;
+
+		if (random_pool_offset == RANDOM_POOL_SIZE)
+		{
+			if (len >= RANDOM_POOL_SIZE)
+			{
+				random_strong_fill(buf, len);
+				return;
+			}
+
+			random_strong_fill(random_pool, RANDOM_POOL_SIZE);
+			random_pool_offset = 0;
+		}
+
+		nbytes = Min(len, (size_t) (RANDOM_POOL_SIZE - random_pool_offset));
+
+		memcpy(buf, random_pool + random_pool_offset, nbytes);
+		memset(random_pool + random_pool_offset, 0, nbytes);
+
+		random_pool_offset += nbytes;
+		buf += nbytes;
+		len -= nbytes;
+	}
+}
+
+/*
+ * random_fast_seed
+ *	seed the fast generator from the strong one
+ */
+static void
+random_fast_seed(void)
+{
+	/* the state must not be all zeros */
+	do
+	{
+		random_strong_fill((unsigned char *) random_fast_state,
+						   sizeof(random_fast_state));
+	} while ((random_fast_state[0] | random_fast_state[1] |
+			  random_fast_state[2] | random_fast_state[3]) == 0);
+
+	random_fast_remaining = RANDOM_FAST_RESEED;
+	random_fast_pid = MyProcPid;
+}
+
+/*
+ * random_fast_next
+ *	next 64-bit output of the xoshiro256** generator
+ *
+ * See https://prng.di.unimi.it/xoshiro256starstar.c
+ */
+static inline uint64
+random_fast_next(uint64 *s)
+{
+	uint64		x = s[1] * 5;
+	uint64		result = ((x << 7) | (x >> 57)) * 9;
+	uint64		t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+
+	s[2] ^= t;
+
+	s[3] = (s[3] << 45) | (s[3] >> 19);
+
+	return result;
+}
+
+/*
+ * random_fast_fill
+ *	fill the buffer with random bytes from the fast generator
+ *
+ * Just like the pool of strong random bytes, the state is discarded when
+ * the process forks (so that two processes don't produce the same bytes),
+ * and we also reseed after producing RANDOM_FAST_RESEED bytes.
+ */
+static void
+random_fast_fill(unsigned char *buf, size_t len)
+{
+	while (len > 0)
+	{
+		size_t	nbytes;
+
+		if (random_fast_pid != MyProcPid || random_fast_remaining == 0)
+			random_fast_seed();
+
+		nbytes = Min(len, random_fast_remaining);
+
+		random_fast_remaining -= nbytes;
+		len -= nbytes;
+
+		while (nbytes > 0)
+		{
+			uint64	r = random_fast_next(random_fast_state);
+			size_t	n = Min(nbytes, sizeof(uint64));
+
+			memcpy(buf, &r, n);
+
+			buf += n;
+			nbytes -= n;
+		}
+	}
+}
+
+/*
+ * random_fast_jump
+ *	advance the xoshiro256** state using a jump polynomial
+ *
+ * With the jump polynomial this is equivalent to 2^128 calls of
+ * random_fast_next, with the long jump polynomial to 2^192 calls. So
+ * jumps split the sequence into non-overlapping streams.
+ */
+static void
+random_fast_jump(uint64 *s, const uint64 *poly)
+{
+	uint64	t[4] = {0, 0, 0, 0};
+	int		i;
+	int		b;
+
+	for (i = 0; i < 4; i++)
+	{
+		for (b = 0; b < 64; b++)
+		{
+			if (poly[i] & (UINT64CONST(1) << b))
+			{
+				t[0] ^= s[0];
+				t[1] ^= s[1];
+				t[2] ^= s[2];
+				t[3] ^= s[3];
+			}
+
+			(void) random_fast_next(s);
+		}
+	}
+
+	memcpy(s, t, sizeof(t));
+}
+
+static const uint64 random_jump_poly[4] = {
+	UINT64CONST(0x180ec6d33cfd0aba), UINT64CONST(0xd5a61266f0c9392c),
+	UINT64CONST(0xa9582618e03fc9aa), UINT64CONST(0x39abdc4529b1661c)
+};
+
+static const uint64 random_long_jump_poly[4] = {
+	UINT64CONST(0x76e15d3efefdcbbf), UINT64CONST(0xc5004e441c522fb3),
+	UINT64CONST(0x77710069854ee241), UINT64CONST(0x39109bb02acbe635)
+};
+
+/*
+ * random_seeded_reset
+ *	restart the seeded generator (assign hook)
+ */
+static void
+random_seeded_reset(int newval, void *extra)
+{
+	random_seeded_valid = false;
+}
+
+/*
+ * random_seeded_fill
+ *	fill the buffer with random bytes from the seeded generator
+ *
+ * The state is derived from the seed using splitmix64 (as recommended for
+ * xoshiro), so the same seed always produces the same data (on the same
+ * platform - the bytes are copied in native byte order). That's useful for
+ * repeatable benchmarks, but the UUIDs are entirely predictable, so we
+ * warn about that whenever the stream is (re)started.
+ *
+ * Concurrent sessions (and parallel workers) must not generate the same
+ * data, otherwise they'd generate the same UUIDs. So the state is moved
+ * to the stream selected by sequential_uuids.random_stream (or by the
+ * backend ID, for workers the leader's one) by long jumps, and parallel
+ * workers then jump within the leader's stream, by ParallelWorkerNumber + 1
+ * jumps.
+ */
+static void
+random_seeded_fill(unsigned char *buf, size_t len)
+{
+	if (!random_seeded_valid)
+	{
+		uint64	x = (uint64) random_seed;
+		int		stream;
+		int		i;
+
+		for (i = 0; i < 4; i++)
+		{
+			uint64	z = (x += UINT64CONST(0x9e3779b97f4a7c15));
+
+			z = (z ^ (z >> 30)) * UINT64CONST(0xbf58476d1ce4e5b9);
+			z = (z ^ (z >> 27)) * UINT64CONST(0x94d049bb133111eb);
+			random_seeded_state[i] = z ^ (z >> 31);
+		}
+
+		stream = (random_stream >= 0) ? random_stream : BackendRandomStream();
+
+		for (i = 0; i < stream; i++)
+			random_fast_jump(random_seeded_state, random_long_jump_poly);
+
+		if (IsParallelWorker())
+		{
+			for (i = 0; i <= ParallelWorkerNumber; i++)
+				random_fast_jump(random_seeded_state, random_jump_poly);
+		}
+
+		random_seeded_valid = true;
+
+		/* the leader already warned about it */
+		if (!IsParallelWorker())
+			ereport(WARNING,
+					(errmsg("generating UUIDs using seeded random source, with seed %d and stream %d",
+							random_seed, stream),
+					 errdetail("The generated UUIDs are predictable, and repeat for the same seed and stream."),
+					 errhint("Use this only for benchmarks and testing.")));
+	}
+
+	while (len > 0)
+	{
+		uint64	r = random_fast_next(random_seeded_state);
+		size_t	n = Min(len, sizeof(uint64));
+
+		memcpy(buf, &r, n);
+
+		buf += n;
+		len -= n;
+	}
+}
+
+/*
+ * random_fill
+ *	fill the buffer with random bytes from the configured source
+ */
+static void
+random_fill(unsigned char *buf, size_t len)
+{
+	if (random_source == RANDOM_SOURCE_FAST)
+		random_fast_fill(buf, len);
+	else if (random_source == RANDOM_SOURCE_SEEDED)
+		random_seeded_fill(buf, len);
+	else
+		random_pool_fill(buf, len);
+}
+
+/*
+ * check_sequence_params
+ *	basic sanity checks of the sequence-based generator parameters
+ */
+static void
+check_sequence_params(int32 block_size, int32 block_count)
+{
+	if (block_size < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("block size must be a positive integer")));
+
+	if (block_count < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of blocks must be a positive integer")));
+}
+
+/*
+ * check_time_params
+ *	basic sanity checks of the time-based generator parameters
+ */
+static void
+check_time_params(int32 interval_length, int32 interval_count)
+{
+	if (interval_length < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("length of interval must be a positive integer")));
+
+	if (interval_count < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of intervals must be a positive integer")));
+}
+
+/*
+ * check_sequence_access
+ *	make sure the relation is a sequence we're allowed to fetch values from
+ */
+static void
+check_sequence_access(Oid relid)
+{
+	if (get_rel_relkind(relid) != RELKIND_SEQUENCE)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a sequence",
+						get_rel_name(relid))));
+
+	/* same check as in nextval */
+	if (pg_class_aclcheck(relid, GetUserId(),
+						  ACL_USAGE | ACL_UPDATE) != ACLCHECK_OK)
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("permission denied for sequence %s",
+						get_rel_name(relid))));
+}
+
+/*
+ * check_batch_size
+ *	make sure the number of UUIDs requested from a bulk generator is sane
+ */
+static void
+check_batch_size(int32 nvalues)
+{
+	if (nvalues < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of UUIDs must be a non-negative integer")));
+}
+
+/*
+ * timestamp_to_unix_usec
+ *	convert PostgreSQL timestamp to microseconds since the Unix epoch
+ */
+static int64
+timestamp_to_unix_usec(TimestampTz ts)
+{
+	return ts + ((int64) (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) *
+				 SECS_PER_DAY * USECS_PER_SEC);
+}
+
+/*
+ * unix_usec_to_timestamp
+ *	convert microseconds since the Unix epoch to PostgreSQL timestamp
+ */
+static TimestampTz
+unix_usec_to_timestamp(int64 usec)
+{
+	return usec - ((int64) (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) *
+				   SECS_PER_DAY * USECS_PER_SEC);
+}
+
+/*
+ * floor_div
+ *	integer division rounding towards negative infinity
+ */
+static int64
+floor_div(int64 a, int64 b)
+{
+	int64	q = a / b;
+
+	if ((a % b != 0) && ((a < 0) != (b < 0)))
+		q--;
+
+	return q;
+}
+
+/*
+ * time_block_span
+ *	determine block IDs of intervals overlapping the [from, to) period
+ *
+ * The blocks are first .. last, and may wrap around (first > last). When
+ * the period is at least as long as the whole cycle, all blocks overlap.
+ * Returns false if the period is empty.
+ */
+static bool
+time_block_span(TimestampTz from, TimestampTz to, int32 interval_length,
+				int32 interval_count, int64 *first, int64 *last)
+{
+	int64	length = (int64) interval_length * USECS_PER_SEC;
+	int64	first_interval;
+	int64	last_interval;
+
+	if (from >= to)
+		return false;
+
+	first_interval = floor_div(timestamp_to_unix_usec(from), length);
+	last_interval = floor_div(timestamp_to_unix_usec(to) - 1, length);
+
+	if (last_interval - first_interval + 1 >= interval_count)
+	{
+		*first = 0;
+		*last = interval_count - 1;
+		return true;
+	}
+
+	*first = ((first_interval % interval_count) + interval_count) % interval_count;
+	*last = ((last_interval % interval_count) + interval_count) % interval_count;
+
+	return true;
+}
+
+/*
+ * check_block_prefix
+ *	make sure the block ID is stored at the beginning of the UUID
+ *
+ * Key ranges of blocks exist only when the block ID is the first field
+ * of the UUID, which is not the case when the node ID goes first.
+ */
+static void
+check_block_prefix(void)
+{
+	if (node_id >= 0 && node_id_first)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("UUID ranges are not supported with the node ID placed before the block ID"),
+				 errhint("Disable sequential_uuids.node_id_first.")));
+}
+
+/*
+ * virtual_clock_reset
+ *	restart the virtual clock (assign hook)
+ */
+static void
+virtual_clock_reset(int newval, void *extra)
+{
+	virtual_clock_valid = false;
+}
+
+/*
+ * virtual_clock_rate_reset
+ *	restart the virtual clock (assign hook for the rate)
+ */
+static void
+virtual_clock_rate_reset(double newval, void *extra)
+{
+	virtual_clock_valid = false;
+}
+
+/*
+ * virtual_clock_usec
+ *	read the virtual clock
+ *
+ * The virtual clock starts at sequential_uuids.virtual_clock_start, and each
+ * read advances it by 1/virtual_clock_rate seconds, independently of the
+ * real time. So the time-based generators produce the same block IDs in
+ * each run (as if the UUIDs were generated at a constant rate), which
+ * together with the seeded random source makes the UUIDs repeatable.
+ */
+static int64
+virtual_clock_usec(void)
+{
+	if (!virtual_clock_valid)
+	{
+		virtual_clock_reads = 0;
+		virtual_clock_valid = true;
+
+		ereport(WARNING,
+				(errmsg("generating UUIDs using virtual clock"),
+				 errdetail("The time-based generators do not use the real time."),
+				 errhint("Use this only for benchmarks and testing.")));
+	}
+
+	return (int64) virtual_clock_start * USECS_PER_SEC +
+		(int64) ((double) virtual_clock_reads++ * USECS_PER_SEC / virtual_clock_rate);
+}
+
+/*
+ * time_now_usec
+ *	read the current time, as microseconds since the Unix epoch
+ *
+ * The clock is selected by sequential_uuids.clock_source. The coarse clock
+ * is much cheaper to read, but only has a resolution of a few milliseconds.
+ * Where it's not available, we use the regular clock.
+ */
+static int64
+time_now_usec(void)
+{
+	struct timeval	tv;
+
+	switch ((ClockSource) clock_source)
+	{
+		case CLOCK_SOURCE_STATEMENT:
+			return timestamp_to_unix_usec(GetCurrentStatementStartTimestamp());
+
+		case CLOCK_SOURCE_TRANSACTION:
+			return timestamp_to_unix_usec(GetCurrentTransactionStartTimestamp());
+
+		case CLOCK_SOURCE_VIRTUAL:
+			return virtual_clock_usec();
+
+		case CLOCK_SOURCE_COARSE:
+#ifdef CLOCK_REALTIME_COARSE
+			{
+				struct timespec	ts;
+
+				if (clock_gettime(CLOCK_REALTIME_COARSE, &ts) != 0)
+					elog(ERROR, "clock_gettime call failed");
+
+				return (int64) ts.tv_sec * USECS_PER_SEC + ts.tv_nsec / 1000;
+			}
+#endif
+			/* FALLTHROUGH */
+
+		case CLOCK_SOURCE_REALTIME:
+			break;
+	}
+
+	if (gettimeofday(&tv, NULL) != 0)
+		elog(ERROR, "gettimeofday call failed");
+
+	return (int64) tv.tv_sec * USECS_PER_SEC + tv.tv_usec;
+}
+
+/*
+ * uuid_set_block_bound
+ *	set the UUID to the smallest value with the given block ID
+ *
+ * Assumes the block ID is stored at the beginning of the UUID. The block
+ * may be one past the largest block ID (block_count), in which case this
+ * produces the exclusive upper bound of the last block. When that does
+ * not fit into the prefix, the largest possible UUID is produced instead
+ * (no generated UUID is equal to it, thanks to the version flags).
+ */
+static void
+uuid_set_block_bound(pg_uuid_t *uuid, int64 block, int prefix_bits)
+{
+	if (block >= ((int64) 1 << prefix_bits))
+	{
+		memset(uuid->data, 0xFF, UUID_LEN);
+		return;
+	}
+
+	memset(uuid->data, 0, UUID_LEN);
+	squuid_set_bits(uuid->data, 0, block, prefix_bits);
+}
+
+/*
+ * uuid_apply_layout_scalar
+ *	apply the layout to a run of UUIDs (plain C implementation)
+ */
+static void
+uuid_apply_layout_scalar(pg_uuid_t *uuids, int nvalues,
+						 const pg_uuid_t *mask, const pg_uuid_t *bits)
+{
+	uint64	m[2];
+	uint64	b[2];
+	int		i;
+
+	memcpy(m, mask->data, UUID_LEN);
+	memcpy(b, bits->data, UUID_LEN);
+
+	for (i = 0; i < nvalues; i++)
+	{
+		uint64	v[2];
+
+		memcpy(v, uuids[i].data, UUID_LEN);
+
+		v[0] = (v[0] & m[0]) | b[0];
+		v[1] = (v[1] & m[1]) | b[1];
+
+		memcpy(uuids[i].data, v, UUID_LEN);
+	}
+}
+
+#ifdef USE_X86_LAYOUT_KERNELS
+/*
+ * uuid_apply_layout_sse2
+ *	apply the layout to a run of UUIDs (SSE2, one UUID per instruction)
+ */
+static void
+uuid_apply_layout_sse2(pg_uuid_t *uuids, int nvalues,
+					   const pg_uuid_t *mask, const pg_uuid_t *bits)
+{
+	__m128i	m = _mm_loadu_si128((const __m128i *) mask->data);
+	__m128i	b = _mm_loadu_si128((const __m128i *) bits->data);
+	int		i;
+
+	for (i = 0; i < nvalues; i++)
+	{
+		__m128i	v = _mm_loadu_si128((const __m128i *) uuids[i].data);
+
+		v = _mm_or_si128(_mm_and_si128(v, m), b);
+
+		_mm_storeu_si128((__m128i *) uuids[i].data, v);
+	}
+}
+
+/*
+ * uuid_apply_layout_avx2
+ *	apply the layout to a run of UUIDs (AVX2, two UUIDs per instruction)
+ */
+__attribute__((target("avx2")))
+static void
+uuid_apply_layout_avx2(pg_uuid_t *uuids, int nvalues,
+					   const pg_uuid_t *mask, const pg_uuid_t *bits)
+{
+	__m256i	m = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) mask->data));
+	__m256i	b = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) bits->data));
+	int		i;
+
+	for (i = 0; i + 2 <= nvalues; i += 2)
+	{
+		__m256i	v = _mm256_loadu_si256((const __m256i *) uuids[i].data);
+
+		v = _mm256_or_si256(_mm256_and_si256(v, m), b);
+
+		_mm256_storeu_si256((__m256i *) uuids[i].data, v);
+	}
+
+	/* the last UUID, if the count is odd */
+	if (i < nvalues)
+		uuid_apply_layout_sse2(&uuids[i], nvalues - i, mask, bits);
+}
+#endif
+
+/*
+ * uuid_apply_layout_choose
+ *	pick the best layout kernel supported by the CPU
+ */
+static uuid_apply_layout_fn
+uuid_apply_layout_choose(void)
+{
+#ifdef USE_X86_LAYOUT_KERNELS
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		return uuid_apply_layout_avx2;
+
+	return uuid_apply_layout_sse2;
+#else
+	return uuid_apply_layout_scalar;
+#endif
+}
+
+/*
+ * uuid_compare_raw
+ *	qsort comparator, ordering UUIDs the same way as the uuid opclass
+ */
+static int
+uuid_compare_raw(const void *a, const void *b)
+{
+	return memcmp(a, b, UUID_LEN);
+}
+
+/*
+ * sequence_range_params
+ *	read the sequence parameters relevant for reserving a range of values
+ */
+static void
+sequence_range_params(Oid relid, int64 *incby, int64 *cache, int64 *seqmin,
+					  int64 *seqmax)
+{
+	HeapTuple			tuple;
+	Form_pg_sequence	seqform;
+
+	tuple = SearchSysCache1(SEQRELID, ObjectIdGetDatum(relid));
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for sequence %u", relid);
+
+	seqform = (Form_pg_sequence) GETSTRUCT(tuple);
+
+	*incby = seqform->seqincrement;
+	*cache = seqform->seqcache;
+	*seqmin = seqform->seqmin;
+	*seqmax = seqform->seqmax;
+
+	ReleaseSysCache(tuple);
+}
+
+/*
+ * sequence_reserve_range
+ *	try to reserve a contiguous range of values from a sequence
+ *
+ * The first value of the range is obtained by a regular nextval call, and
+ * then the sequence is moved to the last value of the range with a single
+ * setval. If the range would exceed the sequence limits (in which case
+ * the sequence either cycles or fails), we don't reserve anything and let
+ * the caller fetch the remaining values one by one, so that the regular
+ * sequence behavior applies.
+ *
+ * The nextval and setval have to be atomic, otherwise the setval might
+ * move the sequence back over values handed out by other sessions in the
+ * meantime. So we hold a lock conflicting with nextval (which acquires
+ * RowExclusiveLock on the sequence) for the duration, which only works
+ * for sequences without CACHE - with cached values, the nextval may
+ * return a value from the backend cache, far below the last value of the
+ * sequence. nextval holds the lock until the end of the transaction, so
+ * with wait = false we only try to acquire the lock, and fall back to
+ * fetching the values one by one when it's not available (e.g. because
+ * another transaction generates UUIDs from the same sequence right now).
+ *
+ * Sequences with CACHE, and ranges that can't fit between the sequence
+ * limits at all, are recognized from the catalog before taking the lock,
+ * so that we don't block other sessions only to give up. The parameters
+ * are checked again once we hold the lock, as a concurrent ALTER SEQUENCE
+ * might have changed them in the meantime.
+ *
+ * When the range is not reserved, *first is still set to the next value
+ * from the sequence (obtained by a regular nextval call).
+ *
+ * The caller is expected to have checked permissions on the sequence.
+ */
+static bool
+sequence_reserve_range(Oid relid, int64 nvalues, bool wait, int64 *first,
+					   int64 *increment)
+{
+	int64				incby;
+	int64				cache;
+	int64				seqmin;
+	int64				seqmax;
+	uint64				step;
+	uint64				distance;
+
+	if (nvalues <= 1)
+	{
+		*first = nextval_internal(relid, false);
+		return false;
+	}
+
+	/* cheap checks first, without any lock */
+	sequence_range_params(relid, &incby, &cache, &seqmin, &seqmax);
+
+	step = (incby > 0) ? (uint64) incby : ((uint64) 0 - (uint64) incby);
+
+	if ((cache != 1) ||
+		((uint64) (nvalues - 1) > ((uint64) seqmax - (uint64) seqmin) / step))
+	{
+		*first = nextval_internal(relid, false);
+		return false;
+	}
+
+	if (wait)
+		LockRelationOid(relid, ShareRowExclusiveLock);
+	else if (!ConditionalLockRelationOid(relid, ShareRowExclusiveLock))
+	{
+		*first = nextval_internal(relid, false);
+		return false;
+	}
+
+	/* ALTER SEQUENCE conflicts with the lock, so this can't change now */
+	sequence_range_params(relid, &incby, &cache, &seqmin, &seqmax);
+
+	*first = nextval_internal(relid, false);
+
+	if (cache != 1)
+	{
+		UnlockRelationOid(relid, ShareRowExclusiveLock);
+		return false;
+	}
+
+	/* distance to the sequence limit, as number of increments */
+	if (incby > 0)
+		distance = ((uint64) seqmax - (uint64) *first) / (uint64) incby;
+	else
+		distance = ((uint64) *first - (uint64) seqmin) / ((uint64) 0 - (uint64) incby);
+
+	if (distance < (uint64) (nvalues - 1))
+	{
+		UnlockRelationOid(relid, ShareRowExclusiveLock);
+		return false;
+	}
+
+	/* the lock guarantees *first is the last value, so this only advances */
+	DirectFunctionCall3(setval3_oid,
+						ObjectIdGetDatum(relid),
+						Int64GetDatum(*first + (nvalues - 1) * incby),
+						BoolGetDatum(true));
+
+	UnlockRelationOid(relid, ShareRowExclusiveLock);
+
+	*increment = incby;
+
+	return true;
+}
+
+/*
+ * sequence_prefetch_nextval
+ *	get the next sequence value, using the backend-local prefetched range
+ *
+ * With sequential_uuids.sequence_prefetch set to N > 1, the backend reserves
+ * N values from the sequence at once, and then hands them out locally
+ * without touching the sequence. This is similar to the sequence CACHE,
+ * but it does not require altering the sequence and it amortizes even the
+ * nextval call itself. The caveats are the same - values are not handed
+ * out in global order (but the block IDs are still roughly monotonic), and
+ * unused prefetched values are lost when the backend exits.
+ *
+ * The range is reserved only when the sequence is not locked by other
+ * transactions, see sequence_reserve_range. So this is effective for
+ * sequences without CACHE and with only a few concurrent writers, with
+ * many sessions most attempts fail. After a failed attempt we use plain
+ * nextval for the next sequence_prefetch values, not to check the catalog
+ * and the lock for every value.
+ *
+ * Sets prefetched to true when the value was handed out from the range,
+ * i.e. without calling nextval.
+ *
+ * The caller is expected to have checked permissions on the sequence.
+ */
+static int64
+sequence_prefetch_nextval(Oid relid, bool *prefetched)
+{
+	SequencePrefetch   *entry;
+	bool				found;
+	int64				val;
+
+	*prefetched = false;
+
+	if (sequence_prefetch <= 1)
+		return nextval_internal(relid, false);
+
+	if (prefetch_hash == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(SequencePrefetch);
+
+		prefetch_hash = hash_create("sequential_uuids prefetched values",
+									16, &ctl, HASH_ELEM | HASH_BLOBS);
+	}
+
+	entry = (SequencePrefetch *) hash_search(prefetch_hash, &relid,
+											 HASH_ENTER, &found);
+
+	if (!found)
+	{
+		entry->remaining = 0;
+		entry->backoff = 0;
+	}
+
+	if (entry->remaining > 0)
+	{
+		val = entry->next;
+
+		entry->next += entry->increment;
+		entry->remaining--;
+
+		*prefetched = true;
+
+		return val;
+	}
+
+	/* the last attempt failed, don't try again for a while */
+	if (entry->backoff > 0)
+	{
+		entry->backoff--;
+		return nextval_internal(relid, false);
+	}
+
+	if (sequence_reserve_range(relid, sequence_prefetch, false, &val,
+							   &entry->increment))
+	{
+		entry->next = val + entry->increment;
+		entry->remaining = sequence_prefetch - 1;
+	}
+	else
+		entry->backoff = sequence_prefetch - 1;
+
+	return val;
+}
+
+/*
+ * shared_state_size
+ *	size of the shared memory segment, with max_counters counters
+ */
+static Size
+shared_state_size(void)
+{
+	return add_size(offsetof(SharedState, counters),
+					mul_size(max_counters, sizeof(SharedCounter)));
+}
+
+/*
+ * shared_memory_size
+ *	total amount of shared memory, including the statistics hash table
+ */
+static Size
+shared_memory_size(void)
+{
+	return add_size(shared_state_size(),
+					hash_estimate_size(max_stats, sizeof(SharedStatsEntry)));
+}
+
+#if PG_VERSION_NUM >= 150000
+/*
+ * sequential_uuids_shmem_request
+ *	request shared memory and the LWLock (PG15+)
+ */
+static void
+sequential_uuids_shmem_request(void)
+{
+	if (prev_shmem_request_hook)
+		prev_shmem_request_hook();
+
+	RequestAddinShmemSpace(shared_memory_size());
+	RequestNamedLWLockTranche("sequential_uuids", 1);
+}
+#endif
+
+/*
+ * sequential_uuids_shmem_startup
+ *	allocate or attach to the shared memory segment
+ *
+ * When initializing the segment (in postmaster), the counters persisted
+ * during the last clean shutdown are loaded, and we arrange for them to
+ * be persisted again at shutdown.
+ */
+static void
+sequential_uuids_shmem_startup(void)
+{
+	bool		found;
+	HASHCTL		info;
+
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	shared = ShmemInitStruct("sequential_uuids", shared_state_size(), &found);
+
+	if (!found)
+	{
+		shared->lock = &(GetNamedLWLockTranche("sequential_uuids"))->lock;
+		shared->ncounters = 0;
+
+		counters_load();
+	}
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(StatsKey);
+	info.entrysize = sizeof(SharedStatsEntry);
+
+	shared_stats_hash = ShmemInitHash("sequential_uuids stats",
+									  max_stats, max_stats,
+									  &info, HASH_ELEM | HASH_BLOBS);
+
+	LWLockRelease(AddinShmemInitLock);
+
+	if (!IsUnderPostmaster)
+		on_shmem_exit(counters_shmem_shutdown, (Datum) 0);
+}
+
+/*
+ * counter_seed
+ *	initial value of a counter (after creation or restart)
+ *
+ * The counter is seeded from the current time in microseconds, and we
+ * never go below that even when restoring a persisted value. So as long
+ * as the counter is incremented less than once per microsecond (on
+ * average), it never goes backwards, even after a crash (when the values
+ * are not persisted), or when the persisted file is stale.
+ */
+static uint64
+counter_seed(uint64 persisted)
+{
+	struct timeval	tv;
+	uint64			seed;
+
+	if (gettimeofday(&tv, NULL) != 0)
+		elog(ERROR, "gettimeofday call failed");
+
+	seed = (uint64) tv.tv_sec * USECS_PER_SEC + tv.tv_usec;
+
+	return Max(seed, persisted);
+}
+
+/*
+ * shared_counter_init
+ *	initialize a new counter in shared memory
+ */
+static void
+shared_counter_init(SharedCounter *counter, const char *name, uint64 value,
+					int64 limit)
+{
+	strlcpy(counter->name, name, NAMEDATALEN);
+	pg_atomic_init_u64(&counter->value, value);
+	counter->limit = limit;
+
+	SpinLockInit(&counter->mutex);
+	counter->block_uuids = 0;
+	counter->block_start = 0;
+	counter->rate = 0;
+
+	counter->skip_blocks = 0;
+	counter->skip_count = 0;
+}
+
+/*
+ * counters_load
+ *	load counters persisted at the last clean shutdown
+ *
+ * The file is removed after loading, so that after a crash (when the file
+ * is not written) we don't load stale values again.
+ */
+static void
+counters_load(void)
+{
+	FILE	   *file;
+	uint32		header;
+	int32		num;
+	int			i;
+
+	file = AllocateFile(COUNTERS_DUMP_FILE, PG_BINARY_R);
+	if (file == NULL)
+	{
+		if (errno != ENOENT)
+			goto read_error;
+		return;
+	}
+
+	if (fread(&header, sizeof(uint32), 1, file) != 1 ||
+		fread(&num, sizeof(int32), 1, file) != 1)
+		goto read_error;
+
+	if (header != COUNTERS_FILE_HEADER && header != COUNTERS_FILE_HEADER_V1)
+		goto data_error;
+
+	for (i = 0; i < num; i++)
+	{
+		char			name[NAMEDATALEN];
+		uint64			value;
+		int64			limit = PG_INT64_MAX;
+		SharedCounter  *counter;
+
+		if (fread(name, NAMEDATALEN, 1, file) != 1 ||
+			fread(&value, sizeof(uint64), 1, file) != 1)
+			goto read_error;
+
+		if (header == COUNTERS_FILE_HEADER &&
+			fread(&limit, sizeof(int64), 1, file) != 1)
+			goto read_error;
+
+		/* if max_counters was reduced, some counters may not fit */
+		if (shared->ncounters >= max_counters)
+			break;
+
+		counter = &shared->counters[shared->ncounters++];
+
+		/* leased counters have to stay within the range, so no seeding */
+		if (limit != PG_INT64_MAX)
+			shared_counter_init(counter, name, value, limit);
+		else
+			shared_counter_init(counter, name, counter_seed(value), limit);
+	}
+
+	FreeFile(file);
+
+	unlink(COUNTERS_DUMP_FILE);
+
+	return;
+
+read_error:
+	ereport(LOG,
+			(errcode_for_file_access(),
+			 errmsg("could not read file \"%s\": %m",
+					COUNTERS_DUMP_FILE)));
+	goto fail;
+data_error:
+	ereport(LOG,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			 errmsg("ignoring invalid data in file \"%s\"",
+					COUNTERS_DUMP_FILE)));
+fail:
+	if (file)
+		FreeFile(file);
+
+	unlink(COUNTERS_DUMP_FILE);
+}
+
+/*
+ * counters_shmem_shutdown
+ *	persist the counters at shutdown
+ *
+ * Called in postmaster (or a standalone backend) at shutdown. We don't
+ * persist anything during a crash - the counters will be seeded from
+ * current time instead.
+ */
+static void
+counters_shmem_shutdown(int code, Datum arg)
+{
+	FILE	   *file;
+	int32		num;
+	int			i;
+
+	if (code)
+		return;
+
+	if (!shared)
+		return;
+
+	file = AllocateFile(COUNTERS_DUMP_FILE ".tmp", PG_BINARY_W);
+	if (file == NULL)
+		goto error;
+
+	num = shared->ncounters;
+
+	if (fwrite(&COUNTERS_FILE_HEADER, sizeof(uint32), 1, file) != 1 ||
+		fwrite(&num, sizeof(int32), 1, file) != 1)
+		goto error;
+
+	for (i = 0; i < num; i++)
+	{
+		SharedCounter  *counter = &shared->counters[i];
+		uint64			value = pg_atomic_read_u64(&counter->value);
+
+		if (fwrite(counter->name, NAMEDATALEN, 1, file) != 1 ||
+			fwrite(&value, sizeof(uint64), 1, file) != 1 ||
+			fwrite(&counter->limit, sizeof(int64), 1, file) != 1)
+			goto error;
+	}
+
+	if (FreeFile(file))
+	{
+		file = NULL;
+		goto error;
+	}
+
+	(void) durable_rename(COUNTERS_DUMP_FILE ".tmp", COUNTERS_DUMP_FILE, LOG);
+
+	return;
+
+error:
+	ereport(LOG,
+			(errcode_for_file_access(),
+			 errmsg("could not write file \"%s\": %m",
+					COUNTERS_DUMP_FILE ".tmp")));
+	if (file)
+		FreeFile(file);
+
+	unlink(COUNTERS_DUMP_FILE ".tmp");
+}
+
+/*
+ * check_shared_state
+ *	make sure the shared memory segment is available
+ */
+static void
+check_shared_state(void)
+{
+	if (!shared)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("sequential_uuids must be loaded via shared_preload_libraries")));
+}
+
+/*
+ * shared_counter_find
+ *	find a shared counter by name (the caller holds the lock)
+ */
+static SharedCounter *
+shared_counter_find(const char *name)
+{
+	int				i;
+
+	for (i = 0; i < shared->ncounters; i++)
+	{
+		if (strcmp(shared->counters[i].name, name) == 0)
+			return &shared->counters[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * shared_counter_add
+ *	add a new counter (the caller holds the lock in exclusive mode)
+ */
+static SharedCounter *
+shared_counter_add(const char *name, uint64 value, int64 limit)
+{
+	SharedCounter  *counter;
+
+	if (shared->ncounters >= max_counters)
+	{
+		LWLockRelease(shared->lock);
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("too many shared counters"),
+				 errhint("Increase sequential_uuids.max_counters.")));
+	}
+
+	counter = &shared->counters[shared->ncounters];
+
+	shared_counter_init(counter, name, value, limit);
+
+	/* make the counter visible only once it's fully initialized */
+	shared->ncounters++;
+
+	return counter;
+}
+
+/*
+ * shared_counter_lookup
+ *	find a shared counter by name, creating it if needed
+ *
+ * Counters are never removed, so the pointer remains valid and may be
+ * cached by the caller. Lookups only need a shared lock, the exclusive
+ * lock is acquired only when adding a new counter.
+ */
+static SharedCounter *
+shared_counter_lookup(const char *name)
+{
+	SharedCounter  *counter;
+
+	check_shared_state();
+
+	LWLockAcquire(shared->lock, LW_SHARED);
+	counter = shared_counter_find(name);
+	LWLockRelease(shared->lock);
+
+	if (counter)
+		return counter;
+
+	LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+	/* somebody might have added the counter in the meantime */
+	counter = shared_counter_find(name);
+
+	if (!counter)
+		counter = shared_counter_add(name, counter_seed(0), PG_INT64_MAX);
+
+	LWLockRelease(shared->lock);
+
+	return counter;
+}
+
+/*
+ * stats_add
+ *	add local counters to a shared statistics entry, and reset them
+ */
+static void
+stats_add(SharedStatsEntry *sentry, StatsCounters *counters)
+{
+	SpinLockAcquire(&sentry->mutex);
+
+	sentry->counters.calls += counters->calls;
+	sentry->counters.uuids += counters->uuids;
+	sentry->counters.random_bytes += counters->random_bytes;
+	sentry->counters.nextval_avoided += counters->nextval_avoided;
+	sentry->counters.block_transitions += counters->block_transitions;
+	sentry->counters.wraparounds += counters->wraparounds;
+	sentry->counters.random_time += counters->random_time;
+
+	SpinLockRelease(&sentry->mutex);
+
+	memset(counters, 0, sizeof(StatsCounters));
+}
+
+/*
+ * stats_flush
+ *	add the backend-local statistics to the shared entries
+ *
+ * Most of the time the shared entries already exist, so we only need a
+ * shared lock (and the per-entry spinlock). Missing entries are added in
+ * a second pass, with an exclusive lock. If the hash table is full, the
+ * statistics are discarded (the same entries are not tracked).
+ */
+static void
+stats_flush(void)
+{
+	HASH_SEQ_STATUS		status;
+	LocalStatsEntry	   *entry;
+	bool				missing = false;
+
+	if (!local_stats_pending || !shared || !shared_stats_hash)
+		return;
+
+	LWLockAcquire(shared->lock, LW_SHARED);
+
+	hash_seq_init(&status, local_stats_hash);
+	while ((entry = (LocalStatsEntry *) hash_seq_search(&status)) != NULL)
+	{
+		SharedStatsEntry   *sentry;
+
+		if (entry->counters.calls == 0)
+			continue;
+
+		sentry = (SharedStatsEntry *) hash_search(shared_stats_hash,
+												  &entry->key,
+												  HASH_FIND, NULL);
+
+		if (!sentry)
+		{
+			missing = true;
+			continue;
+		}
+
+		stats_add(sentry, &entry->counters);
+	}
+
+	LWLockRelease(shared->lock);
+
+	if (missing)
+	{
+		LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+		hash_seq_init(&status, local_stats_hash);
+		while ((entry = (LocalStatsEntry *) hash_seq_search(&status)) != NULL)
+		{
+			SharedStatsEntry   *sentry;
+			bool				found;
+
+			if (entry->counters.calls == 0)
+				continue;
+
+			sentry = (SharedStatsEntry *) hash_search(shared_stats_hash,
+													  &entry->key,
+													  HASH_ENTER_NULL, &found);
+
+			/* hash table full, discard the statistics */
+			if (!sentry)
+			{
+				memset(&entry->counters, 0, sizeof(StatsCounters));
+				continue;
+			}
+
+			if (!found)
+			{
+				SpinLockInit(&sentry->mutex);
+				memset(&sentry->counters, 0, sizeof(StatsCounters));
+			}
+
+			stats_add(sentry, &entry->counters);
+		}
+
+		LWLockRelease(shared->lock);
+	}
+
+	local_stats_pending = false;
+}
+
+/*
+ * stats_xact_callback
+ *	flush the statistics at the end of a transaction
+ */
+static void
+stats_xact_callback(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_PARALLEL_COMMIT:
+		case XACT_EVENT_ABORT:
+		case XACT_EVENT_PARALLEL_ABORT:
+		case XACT_EVENT_PREPARE:
+			stats_flush();
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*
+ * stats_shmem_exit
+ *	flush the statistics when the backend exits
+ */
+static void
+stats_shmem_exit(int code, Datum arg)
+{
+	stats_flush();
+}
+
+/*
+ * stats_local_entry
+ *	get the backend-local statistics entry for generator parameters
+ *
+ * Statistics are only tracked when the library is loaded through
+ * shared_preload_libraries, otherwise this returns NULL. The entries are
+ * never removed, so the pointer may be cached in the prepared generator.
+ */
+static LocalStatsEntry *
+stats_local_entry(GeneratorParams *params)
+{
+	LocalStatsEntry	   *entry;
+	StatsKey			key;
+	bool				found;
+
+	if (!shared || !shared_stats_hash)
+		return NULL;
+
+	if (local_stats_hash == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(StatsKey);
+		ctl.entrysize = sizeof(LocalStatsEntry);
+
+		local_stats_hash = hash_create("sequential_uuids local stats",
+									   16, &ctl, HASH_ELEM | HASH_BLOBS);
+
+		RegisterXactCallback(stats_xact_callback, NULL);
+		before_shmem_exit(stats_shmem_exit, (Datum) 0);
+	}
+
+	memset(&key, 0, sizeof(StatsKey));
+	key.kind = params->kind;
+	key.relid = params->relid;
+	strlcpy(key.counter_name, params->counter_name, NAMEDATALEN);
+	key.block_size = params->block_size;
+	key.block_count = params->block_count;
+	key.interval_unit = params->interval_unit;
+	key.version = params->version;
+
+	entry = (LocalStatsEntry *) hash_search(local_stats_hash, &key,
+											HASH_ENTER, &found);
+
+	if (!found)
+		memset(&entry->counters, 0, sizeof(StatsCounters));
+
+	return entry;
+}
+
+/*
+ * generator_params_settings
+ *	set generator parameters determined by configuration options
+ */
+static void
+generator_params_settings(GeneratorParams *params)
+{
+	/* node ID and stripes are configured for all generators */
+	params->node_id = node_id;
+	params->node_bytes = node_id_bytes;
+	params->node_first = node_id_first;
+	params->stripes = stripes;
+}
+
+/*
+ * generator_params_init
+ *	initialize generator parameters, with all the optional fields unset
+ */
+static void
+generator_params_init(GeneratorParams *params, GeneratorKind kind, Oid relid,
+					  int32 block_size, int32 block_count)
+{
+	memset(params, 0, sizeof(GeneratorParams));
+
+	params->kind = kind;
+	params->relid = relid;
+	params->block_size = block_size;
+	params->block_count = block_count;
+
+	/* interval length is in seconds by default */
+	if (kind == GENERATOR_TIME)
+		params->interval_unit = USECS_PER_SEC;
+
+	params->version = 4;
+
+	generator_params_settings(params);
+}
+
+/*
+ * generator_layout
+ *	compute layout of the UUIDs for the given (already validated) parameters
+ *
+ * Fails if the layout fields do not fit into UUID_LAYOUT_BITS. Used both
+ * when preparing a generator and when decoding UUIDs it produced. The
+ * layout itself is computed by the code shared with clients, we only do
+ * the checks here, so that we can report what's wrong.
+ *
+ * UUIDv7 has a fixed layout (see squuid_layout_init_v7), with 12 bits of
+ * sub-millisecond precision (the "increased clock precision" method of
+ * RFC 9562, section 6.2), so that UUIDs generated by a backend are ordered
+ * even within a millisecond. There's no wrap-around, and the node ID and
+ * stripes are not included.
+ */
+static void
+generator_layout(SeqUUIDGenerator *gen, GeneratorParams *params)
+{
+	int		prefix_bits;
+	int		node_bits;
+	int		stripe_bits;
+	int		position_bits;
+	int64	block_length;
+	int		stripe;
+
+	memset(gen, 0, sizeof(SeqUUIDGenerator));
+	memcpy(&gen->params, params, sizeof(GeneratorParams));
+
+	gen->last_block = PG_INT64_MIN;
+
+	if (params->version == 7)
+	{
+		squuid_layout_init_v7(&gen->layout);
+
+		memset(gen->random_mask.data, 0xFF, UUID_LEN);
+		squuid_set_bits(gen->random_mask.data, 0, 0, gen->layout.layout_bits);
+		gen->random_mask.data[8] &= 0x3f;
+
+		return;
+	}
+
+	/*
+	 * Count the number of bits needed for the block ID. With block_count
+	 * 0 or 1 there is no block ID (the UUID is entirely random).
+	 */
+	prefix_bits = squuid_bits_for_count(params->block_count);
+
+	node_bits = (params->node_id >= 0) ? 8 * params->node_bytes : 0;
+
+	if (params->node_id >= ((int64) 1 << node_bits))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("node ID %d does not fit into %d bytes",
+						params->node_id, params->node_bytes)));
+
+	stripe_bits = squuid_bits_for_count(params->stripes);
+
+	if (params->position_bytes < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of position bytes must be a non-negative integer")));
+
+	position_bits = 8 * Min(params->position_bytes, UUID_LEN);
+
+	if (prefix_bits + node_bits + stripe_bits + position_bits > UUID_LAYOUT_BITS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("UUID layout does not fit into %d bits",
+						UUID_LAYOUT_BITS),
+				 errdetail("The layout requires %d bits for block ID, %d bits for node ID, %d bits for stripe and %d bits for position within block.",
+						   prefix_bits, node_bits, stripe_bits, position_bits)));
+
+	/* adaptive generators determine the block number directly */
+	if (params->kind == GENERATOR_TIME)
+		block_length = (int64) params->block_size * params->interval_unit;
+	else if (params->kind == GENERATOR_ADAPTIVE)
+		block_length = 1;
+	else
+		block_length = params->block_size;
+
+	stripe = (stripe_bits > 0) ? BackendStripeNumber(params->stripes) : 0;
+
+	if (squuid_layout_init(&gen->layout, block_length, params->block_count,
+						   params->node_id, node_bits, params->node_first,
+						   params->stripes, stripe, position_bits,
+						   params->version) != 0)
+		elog(ERROR, "invalid UUID layout");
+
+	/* everything except the layout fields and version flags is random */
+	memset(gen->random_mask.data, 0xFF, UUID_LEN);
+	squuid_set_bits(gen->random_mask.data, 0, 0, gen->layout.layout_bits);
+	gen->random_mask.data[6] &= 0x0f;
+	gen->random_mask.data[8] &= 0x3f;
+}
+
+/*
+ * generator_prepare_with
+ *	prepare a generator for the given parameters, reusing a cached one
+ *
+ * When called with flinfo, the prepared generator is cached in fn_extra
+ * and reused by subsequent calls with the same parameters (which is the
+ * common case e.g. for column defaults with constant arguments). So the
+ * parameters are validated, the layout of the UUIDs is computed and the
+ * permissions on the sequence are checked only once.
+ *
+ * Without flinfo (e.g. in set-returning functions, where fn_extra is used
+ * by the SRF machinery) a new generator is allocated in the current memory
+ * context.
+ *
+ * Counter-based and adaptive generators use the shared counter with the
+ * name from the parameters, unless a counter is supplied by the caller.
+ */
+static SeqUUIDGenerator *
+generator_prepare_with(FmgrInfo *flinfo, GeneratorParams *params,
+					   SharedCounter *counter)
+{
+	SeqUUIDGenerator   *gen = NULL;
+	SeqUUIDGenerator	layout;
+
+	if (flinfo != NULL)
+		gen = (SeqUUIDGenerator *) flinfo->fn_extra;
+
+	/* reuse the cached generator, if the parameters did not change */
+	if (gen != NULL &&
+		memcmp(&gen->params, params, sizeof(GeneratorParams)) == 0)
+		return gen;
+
+	if (params->kind == GENERATOR_SEQUENCE)
+	{
+		check_sequence_params(params->block_size, params->block_count);
+		check_sequence_access(params->relid);
+	}
+	else if (params->kind == GENERATOR_COUNTER)
+		check_sequence_params(params->block_size, params->block_count);
+	else if (params->kind == GENERATOR_ADAPTIVE)
+	{
+		check_sequence_params(params->block_size, params->block_count);
+
+		if (params->max_interval < 1)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("maximum interval must be a positive integer")));
+	}
+	else
+		check_time_params(params->block_size, params->block_count);
+
+	generator_layout(&layout, params);
+
+	if (params->kind == GENERATOR_COUNTER ||
+		params->kind == GENERATOR_ADAPTIVE)
+		layout.counter = counter ? counter : shared_counter_lookup(params->counter_name);
+
+	layout.stats = stats_local_entry(params);
+
+	if (gen == NULL)
+		gen = MemoryContextAlloc(flinfo ? flinfo->fn_mcxt : CurrentMemoryContext,
+								 sizeof(SeqUUIDGenerator));
+
+	memcpy(gen, &layout, sizeof(SeqUUIDGenerator));
+
+	if (flinfo != NULL)
+		flinfo->fn_extra = gen;
+
+	return gen;
+}
+
+/*
+ * generator_prepare
+ *	prepare a generator, using the shared counter (if needed)
+ */
+static SeqUUIDGenerator *
+generator_prepare(FmgrInfo *flinfo, GeneratorParams *params)
+{
+	return generator_prepare_with(flinfo, params, NULL);
+}
+
+/*
+ * adaptive_next_block
+ *	determine block number for the next UUID of an adaptive generator
+ *
+ * The generator switches to the next block when the current one reaches
+ * the target number of UUIDs (block_size), or when it gets older than
+ * max_interval, whichever happens first. So with high generation rates it
+ * behaves like a sequence-based generator (keeping the number of UUIDs per
+ * block, and thus the block's part of the index, close to the target),
+ * while with low rates it behaves like a time-based one (so that blocks
+ * don't stay active forever).
+ *
+ * We also keep an estimate of the generation rate (exponentially smoothed
+ * over completed blocks), so that it's possible to check how often the
+ * blocks are switched, and tune the target.
+ *
+ * When switching to the next block, blocks marked as dense by
+ * uuid_adaptive_skip_dense (for the same block_count) are skipped, so that
+ * after a wrap-around the inserts go to the parts of the index vacuum
+ * already emptied. At least one block is never marked.
+ */
+static int64
+adaptive_next_block(SeqUUIDGenerator *gen)
+{
+	SharedCounter  *counter = gen->counter;
+	int64			now = time_now_usec();
+	int64			max_usec = (int64) gen->params.max_interval * USECS_PER_SEC;
+	int64			block;
+
+	SpinLockAcquire(&counter->mutex);
+
+	block = (int64) pg_atomic_read_u64(&counter->value);
+
+	if (counter->block_start == 0)
+		counter->block_start = now;
+	else if (counter->block_uuids >= gen->params.block_size ||
+			 now - counter->block_start >= max_usec)
+	{
+		int64	elapsed = now - counter->block_start;
+
+		if (elapsed > 0)
+		{
+			double	rate = (double) counter->block_uuids * USECS_PER_SEC / elapsed;
+
+			if (counter->rate == 0)
+				counter->rate = rate;
+			else
+				counter->rate = 0.8 * counter->rate + 0.2 * rate;
+		}
+
+		block++;
+
+		if (counter->skip_count > 0 &&
+			counter->skip_blocks == gen->params.block_count)
+		{
+			int		skipped = 0;
+
+			while (skipped < counter->skip_count)
+			{
+				int32	id = (int32) (block % gen->params.block_count);
+
+				if (!(counter->skip_map[id / 8] & (1 << (id % 8))))
+					break;
+
+				block++;
+				skipped++;
+			}
+		}
+
+		pg_atomic_write_u64(&counter->value, block);
+
+		counter->block_uuids = 0;
+		counter->block_start = now;
+	}
+
+	counter->block_uuids++;
+
+	SpinLockRelease(&counter->mutex);
+
+	return block;
+}
+
+/*
+ * generator_next_value
+ *	get the value determining the next UUID produced by the generator
+ *
+ * For sequence-based generators this is the next value from the sequence,
+ * for time-based generators the current time (in microseconds), and for
+ * counter-based generators the next value of the shared counter. Adaptive
+ * generators return the block number.
+ */
+static int64
+generator_next_value(SeqUUIDGenerator *gen)
+{
+	switch (gen->params.kind)
+	{
+		case GENERATOR_SEQUENCE:
+			{
+				bool	prefetched;
+				int64	value;
+
+				value = sequence_prefetch_nextval(gen->params.relid,
+												  &prefetched);
+
+				if (prefetched && gen->stats)
+					gen->stats->counters.nextval_avoided++;
+
+				return value;
+			}
+
+		case GENERATOR_COUNTER:
+			{
+				int64	value;
+
+				value = (int64) pg_atomic_fetch_add_u64(&gen->counter->value, 1);
+
+				if (value >= gen->counter->limit)
+					ereport(ERROR,
+							(errcode(ERRCODE_SEQUENCE_GENERATOR_LIMIT_EXCEEDED),
+							 errmsg("shared counter \"%s\" reached the end of the leased range",
+									gen->counter->name)));
+
+				return value;
+			}
+
+		case GENERATOR_ADAPTIVE:
+			return adaptive_next_block(gen);
+
+		case GENERATOR_TIME:
+			break;
+	}
+
+	return time_now_usec();
+}
+
+/*
+ * generator_random_fill
+ *	fill the buffer with random bytes, tracking statistics
+ */
+static void
+generator_random_fill(SeqUUIDGenerator *gen, unsigned char *buf, size_t len)
+{
+	instr_time	start;
+	instr_time	duration;
+	bool		timing = (gen->stats && track_random_timing);
+
+	if (timing)
+		INSTR_TIME_SET_CURRENT(start);
+
+	random_fill(buf, len);
+
+	if (!gen->stats)
+		return;
+
+	gen->stats->counters.random_bytes += len;
+
+	if (timing)
+	{
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, start);
+		gen->stats->counters.random_time += INSTR_TIME_GET_MILLISEC(duration);
+	}
+}
+
+/*
+ * generator_track_block
+ *	track block transitions and wrap-arounds for the given value
+ *
+ * The block is compared before wrapping around, so that a transition
+ * into the next cycle is counted as a wrap-around.
+ */
+static void
+generator_track_block(SeqUUIDGenerator *gen, int64 value)
+{
+	int64	block;
+	int64	count = gen->params.block_count;
+
+	if (!gen->stats)
+		return;
+
+	block = value / gen->layout.block_length;
+
+	if (block == gen->last_block)
+		return;
+
+	if (gen->last_block != PG_INT64_MIN)
+	{
+		gen->stats->counters.block_transitions++;
+
+		if (count > 1 && floor_div(block, count) != floor_div(gen->last_block, count))
+			gen->stats->counters.wraparounds++;
+	}
+
+	gen->last_block = block;
+}
+
+/*
+ * generator_make_uuid
+ *	build UUID for the given value, using a prepared generator
+ */
+static void
+generator_make_uuid(SeqUUIDGenerator *gen, pg_uuid_t *uuid, int64 value)
+{
+	int		random_offset = gen->layout.layout_bits / 8;
+
+	/*
+	 * Generate the remaining bytes as random. If the layout ends in the
+	 * middle of a byte, the rest of it is random.
+	 */
+	generator_random_fill(gen, uuid->data + random_offset,
+						  UUID_LEN - random_offset);
+
+	squuid_stamp(&gen->layout, uuid->data, value);
+
+	if (gen->stats)
+	{
+		gen->stats->counters.calls++;
+		gen->stats->counters.uuids++;
+		local_stats_pending = true;
+
+		generator_track_block(gen, value);
+	}
+}
+
+/*
+ * generator_apply_run
+ *	apply the layout for the given value to a run of random UUIDs
+ *
+ * The layout fields are stamped into a template once, and then applied
+ * to all the UUIDs in the run by the layout kernel.
+ */
+static void
+generator_apply_run(SeqUUIDGenerator *gen, pg_uuid_t *uuids, int nvalues,
+					int64 value)
+{
+	pg_uuid_t	bits;
+
+	memset(bits.data, 0, UUID_LEN);
+	squuid_stamp(&gen->layout, bits.data, value);
+
+	uuid_apply_layout(uuids, nvalues, &gen->random_mask, &bits);
+
+	generator_track_block(gen, value);
+}
+
+/*
+ * generator_make_batch
+ *	generate a sorted batch of UUIDs into a buffer, using a prepared generator
+ *
+ * Random data for the whole batch is fetched at once. For sequence-based
+ * generators the sequence values are reserved in one step if possible,
+ * time-based generators read the clock only once (so all UUIDs in the
+ * batch share the same block ID). The UUIDs are sorted, so that they are
+ * inserted into indexes in the key order.
+ *
+ * Consecutive values with the same block ID (and position) produce the
+ * same layout fields, so the batch is processed in such runs, and the
+ * layout is applied to each run at once.
+ */
+static void
+generator_make_batch(SeqUUIDGenerator *gen, pg_uuid_t *uuids, int32 nvalues)
+{
+	int			i;
+	int			run_start;
+	int64		run_value;
+	int64		run_block;
+	uint64		run_position;
+	int64		first = 0;
+	int64		increment = 0;
+	bool		reserved;
+
+	Assert(nvalues >= 0);
+
+	if (nvalues == 0)
+		return;
+
+	generator_random_fill(gen, (unsigned char *) uuids,
+						  nvalues * sizeof(pg_uuid_t));
+
+	if (gen->stats)
+	{
+		gen->stats->counters.calls++;
+		gen->stats->counters.uuids += nvalues;
+		local_stats_pending = true;
+	}
+
+	/* all UUIDs share the same timestamp, so it's a single run */
+	if (gen->params.kind == GENERATOR_TIME)
+	{
+		generator_apply_run(gen, uuids, nvalues, time_now_usec());
+		qsort(uuids, nvalues, sizeof(pg_uuid_t), uuid_compare_raw);
+		return;
+	}
+	else if (gen->params.kind != GENERATOR_SEQUENCE)
+		elog(ERROR, "unexpected generator kind %d", (int) gen->params.kind);
+
+	reserved = sequence_reserve_range(gen->params.relid, nvalues, false,
+									  &first, &increment);
+
+	if (reserved && gen->stats)
+		gen->stats->counters.nextval_avoided += nvalues - 1;
+
+	run_start = 0;
+	run_value = first;
+	run_block = squuid_block_id(&gen->layout, first);
+	run_position = squuid_position(&gen->layout, first);
+
+	for (i = 1; i < nvalues; i++)
+	{
+		int64	value;
+		int64	block;
+		uint64	position;
+
+		if (reserved)
+			value = first + i * increment;
+		else
+			value = nextval_internal(gen->params.relid, false);
+
+		block = squuid_block_id(&gen->layout, value);
+		position = squuid_position(&gen->layout, value);
+
+		if (block == run_block && position == run_position)
+			continue;
+
+		generator_apply_run(gen, &uuids[run_start], i - run_start, run_value);
+
+		run_start = i;
+		run_value = value;
+		run_block = block;
+		run_position = position;
+	}
+
+	generator_apply_run(gen, &uuids[run_start], nvalues - run_start, run_value);
+
+	qsort(uuids, nvalues, sizeof(pg_uuid_t), uuid_compare_raw);
+}
+
+/*
+ * uuid_batch_alloc
+ *	allocate a buffer for a batch of UUIDs (returned by a SRF)
+ */
+static pg_uuid_t *
+uuid_batch_alloc(int32 nvalues)
+{
+	check_batch_size(nvalues);
+
+	return MemoryContextAllocHuge(CurrentMemoryContext,
+								  Max(nvalues, 1) * sizeof(pg_uuid_t));
+}
+
+/*
+ * uuid_batch_array
+ *	allocate an uuid[] array for a batch of UUIDs
+ *
+ * The array is built directly (instead of using construct_array), so that
+ * the batch can be generated straight into the array data, without
+ * allocating and copying the UUIDs separately.
+ */
+static ArrayType *
+uuid_batch_array(int32 nvalues)
+{
+	ArrayType  *result;
+	Size		nbytes;
+
+	check_batch_size(nvalues);
+
+	if (nvalues == 0)
+		return construct_empty_array(UUIDOID);
+
+	if (nvalues > (MaxAllocSize - ARR_OVERHEAD_NONULLS(1)) / UUID_LEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("array size exceeds the maximum allowed (%d)",
+						(int) MaxAllocSize)));
+
+	nbytes = ARR_OVERHEAD_NONULLS(1) + (Size) nvalues * UUID_LEN;
+
+	result = (ArrayType *) palloc(nbytes);
+
+	/* zero the header (including padding), the data is generated later */
+	memset(result, 0, ARR_OVERHEAD_NONULLS(1));
+
+	SET_VARSIZE(result, nbytes);
+	result->ndim = 1;
+	result->dataoffset = 0;
+	result->elemtype = UUIDOID;
+	ARR_DIMS(result)[0] = nvalues;
+	ARR_LBOUND(result)[0] = 1;
+
+	return result;
+}
+
+/*
+ * uuid_batch_bytea
+ *	allocate a bytea for a batch of UUIDs, packed as raw 16-byte values
+ *
+ * Just like uuid_batch_array, the batch is generated straight into the
+ * bytea data (pg_uuid_t has no alignment requirements).
+ */
+static bytea *
+uuid_batch_bytea(int32 nvalues)
+{
+	bytea	   *result;
+	Size		nbytes;
+
+	check_batch_size(nvalues);
+
+	if (nvalues > (MaxAllocSize - VARHDRSZ) / UUID_LEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("bytea size exceeds the maximum allowed (%d)",
+						(int) MaxAllocSize)));
+
+	nbytes = VARHDRSZ + (Size) nvalues * UUID_LEN;
+
+	result = (bytea *) palloc(nbytes);
+	SET_VARSIZE(result, nbytes);
+
+	return result;
+}
+
+/*
+ * uuid_packed_count
+ *	number of UUIDs in a packed bytea, checking the length is valid
+ */
+static int32
+uuid_packed_count(bytea *packed)
+{
+	Size	len = VARSIZE_ANY_EXHDR(packed);
+
+	if (len % UUID_LEN != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid length of packed UUIDs: %zu", len),
+				 errdetail("The length has to be a multiple of %d bytes.",
+						   UUID_LEN)));
+
+	return (int32) (len / UUID_LEN);
+}
+
+/*
+ * uuid_sequence_nextval
+ *	generate sequential UUID using a sequence
+ *
+ * The sequence-based sequential UUID generator define the group size
+ * and group count based on number of UUIDs generated.
+ *
+ * The block_size (65546 by default) determines the number of UUIDs with
+ * the same prefix, and block_count (65536 by default) determines the
+ * number of blocks before wrapping around to 0. This means that with
+ * the default values, the generator wraps around every ~2B UUIDs.
+ *
+ * You may increase (or rather decrease) the parameters if needed, e.g,
+ * by lowering the block size to 256, in wich case the cycle interval
+ * is only 16M values.
+ */
+Datum
+uuid_sequence_nextval(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+
+	generator_params_init(&params, GENERATOR_SEQUENCE, PG_GETARG_OID(0),
+						  PG_GETARG_INT32(1), PG_GETARG_INT32(2));
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_time_nextval
+ *	generate sequential UUID using current time
+ *
+ * The timestamp-based sequential UUID generator define the group size
+ * and group count based on data extracted from current timestamp.
+ *
+ * The interval_length (60 seconds by default) is defined as number of
+ * seconds where UUIDs share the same prefix). The prefix length is
+ * determined by the number of intervals (65536 by default, i.e. 2B).
+ * With these parameters the generator wraps around every ~45 days.
+ */
+Datum
+uuid_time_nextval(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+
+	generator_params_init(&params, GENERATOR_TIME, InvalidOid,
+						  PG_GETARG_INT32(0), PG_GETARG_INT32(1));
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_sequence_nextval_bulk
+ *	generate a set of sequential UUIDs using a sequence
+ *
+ * Generates the requested number of UUIDs in one call, reserving the
+ * sequence values at once. The UUIDs are returned sorted.
+ */
+Datum
+uuid_sequence_nextval_bulk(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	pg_uuid_t	   *uuids;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext		oldcontext;
+		GeneratorParams		params;
+		SeqUUIDGenerator   *gen;
+		int32				nvalues = PG_GETARG_INT32(1);
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		generator_params_init(&params, GENERATOR_SEQUENCE, PG_GETARG_OID(0),
+							  PG_GETARG_INT32(2), PG_GETARG_INT32(3));
+
+		gen = generator_prepare(NULL, &params);
+
+		uuids = uuid_batch_alloc(nvalues);
+		generator_make_batch(gen, uuids, nvalues);
+
+		funcctx->user_fctx = uuids;
+		funcctx->max_calls = nvalues;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	uuids = (pg_uuid_t *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+		SRF_RETURN_NEXT(funcctx, UUIDPGetDatum(&uuids[funcctx->call_cntr]));
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * uuid_sequence_nextval_array
+ *	generate an array of sequential UUIDs using a sequence
+ */
+Datum
+uuid_sequence_nextval_array(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	int32				nvalues = PG_GETARG_INT32(1);
+	ArrayType		   *result;
+
+	generator_params_init(&params, GENERATOR_SEQUENCE, PG_GETARG_OID(0),
+						  PG_GETARG_INT32(2), PG_GETARG_INT32(3));
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	result = uuid_batch_array(nvalues);
+	generator_make_batch(gen, (pg_uuid_t *) ARR_DATA_PTR(result), nvalues);
+
+	PG_RETURN_ARRAYTYPE_P(result);
+}
+
+/*
+ * uuid_time_nextval_series
+ *	generate a set of sequential UUIDs using current time
+ *
+ * All the UUIDs are generated using the same timestamp, and are returned
+ * sorted.
+ */
+Datum
+uuid_time_nextval_series(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	pg_uuid_t	   *uuids;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext		oldcontext;
+		GeneratorParams		params;
+		SeqUUIDGenerator   *gen;
+		int32				nvalues = PG_GETARG_INT32(0);
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		generator_params_init(&params, GENERATOR_TIME, InvalidOid,
+							  PG_GETARG_INT32(1), PG_GETARG_INT32(2));
+
+		gen = generator_prepare(NULL, &params);
+
+		uuids = uuid_batch_alloc(nvalues);
+		generator_make_batch(gen, uuids, nvalues);
+
+		funcctx->user_fctx = uuids;
+		funcctx->max_calls = nvalues;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	uuids = (pg_uuid_t *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+		SRF_RETURN_NEXT(funcctx, UUIDPGetDatum(&uuids[funcctx->call_cntr]));
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * uuid_time_nextval_array
+ *	generate an array of sequential UUIDs using current time
+ */
+Datum
+uuid_time_nextval_array(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	int32				nvalues = PG_GETARG_INT32(0);
+	ArrayType		   *result;
+
+	generator_params_init(&params, GENERATOR_TIME, InvalidOid,
+						  PG_GETARG_INT32(1), PG_GETARG_INT32(2));
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	result = uuid_batch_array(nvalues);
+	generator_make_batch(gen, (pg_uuid_t *) ARR_DATA_PTR(result), nvalues);
+
+	PG_RETURN_ARRAYTYPE_P(result);
+}
+
+/*
+ * uuid_sequence_nextval_packed
+ *	generate a batch of sequential UUIDs using a sequence, as packed bytea
+ *
+ * Same as uuid_sequence_nextval_array, except that the UUIDs are returned
+ * as a single bytea with raw 16-byte values (sorted), which is much more
+ * compact than a text representation when exporting or transferring the
+ * keys. See uuid_unpack and uuid_unpack_array.
+ */
+Datum
+uuid_sequence_nextval_packed(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	int32				nvalues = PG_GETARG_INT32(1);
+	bytea			   *result;
+
+	generator_params_init(&params, GENERATOR_SEQUENCE, PG_GETARG_OID(0),
+						  PG_GETARG_INT32(2), PG_GETARG_INT32(3));
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	result = uuid_batch_bytea(nvalues);
+	generator_make_batch(gen, (pg_uuid_t *) VARDATA(result), nvalues);
+
+	PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * uuid_time_nextval_packed
+ *	generate a batch of sequential UUIDs using current time, as packed bytea
+ */
+Datum
+uuid_time_nextval_packed(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	int32				nvalues = PG_GETARG_INT32(0);
+	bytea			   *result;
+
+	generator_params_init(&params, GENERATOR_TIME, InvalidOid,
+						  PG_GETARG_INT32(1), PG_GETARG_INT32(2));
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	result = uuid_batch_bytea(nvalues);
+	generator_make_batch(gen, (pg_uuid_t *) VARDATA(result), nvalues);
+
+	PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * uuid_pack
+ *	pack an array of UUIDs into bytea, as raw 16-byte values
+ *
+ * The UUIDs are packed in the array order. NULL elements are not allowed,
+ * as there's no way to represent them.
+ */
+Datum
+uuid_pack(PG_FUNCTION_ARGS)
+{
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(0);
+	int32		nvalues;
+	bytea	   *result;
+
+	if (ARR_NDIM(array) > 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+				 errmsg("array must be one-dimensional")));
+
+	if (array_contains_nulls(array))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("array must not contain nulls")));
+
+	nvalues = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+
+	/* without NULLs, the uuid elements are stored one after another */
+	result = uuid_batch_bytea(nvalues);
+	memcpy(VARDATA(result), ARR_DATA_PTR(array), (Size) nvalues * UUID_LEN);
+
+	PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * uuid_unpack
+ *	take apart a packed bytea into a set of UUIDs
+ */
+Datum
+uuid_unpack(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	bytea		   *packed;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext		oldcontext;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* detoast the value only once, in the multi-call context */
+		packed = PG_GETARG_BYTEA_PP(0);
+
+		funcctx->user_fctx = packed;
+		funcctx->max_calls = uuid_packed_count(packed);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	packed = (bytea *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		pg_uuid_t  *uuid = (pg_uuid_t *) VARDATA_ANY(packed);
+
+		SRF_RETURN_NEXT(funcctx, UUIDPGetDatum(&uuid[funcctx->call_cntr]));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * uuid_unpack_array
+ *	take apart a packed bytea into an array of UUIDs
+ */
+Datum
+uuid_unpack_array(PG_FUNCTION_ARGS)
+{
+	bytea	   *packed = PG_GETARG_BYTEA_PP(0);
+	int32		nvalues = uuid_packed_count(packed);
+	ArrayType  *result;
+
+	result = uuid_batch_array(nvalues);
+
+	if (nvalues > 0)
+		memcpy(ARR_DATA_PTR(result), VARDATA_ANY(packed),
+			   (Size) nvalues * UUID_LEN);
+
+	PG_RETURN_ARRAYTYPE_P(result);
+}
+
+/*
+ * uuid_time_nextval_ordered
+ *	generate sequential UUID using current time, ordered within a block
+ *
+ * Works just like uuid_time_nextval, except that the block ID is followed
+ * by position_bytes (2 by default) encoding the position within the
+ * current interval. So within a block the UUIDs are ordered by time too,
+ * and new UUIDs go to the right edge of the block's key range, instead of
+ * being spread over the whole range.
+ *
+ * With the default parameters, the position has ~1ms resolution.
+ */
+Datum
+uuid_time_nextval_ordered(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+
+	generator_params_init(&params, GENERATOR_TIME, InvalidOid,
+						  PG_GETARG_INT32(0), PG_GETARG_INT32(1));
+	params.position_bytes = PG_GETARG_INT32(2);
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_time_nextval_ms
+ *	generate sequential UUID using current time, with interval in milliseconds
+ *
+ * Works just like uuid_time_nextval, except that interval_length (60000 by
+ * default, i.e. 60 seconds) is in milliseconds. This allows using intervals
+ * shorter than a second, e.g. on systems generating so many UUIDs that even
+ * a single second worth of index key range does not fit into cache.
+ */
+Datum
+uuid_time_nextval_ms(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+
+	generator_params_init(&params, GENERATOR_TIME, InvalidOid,
+						  PG_GETARG_INT32(0), PG_GETARG_INT32(1));
+	params.interval_unit = USECS_PER_SEC / 1000;
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_time_nextval_v7
+ *	generate UUIDv7 (RFC 9562) using current time
+ *
+ * The UUIDs start with the Unix timestamp in milliseconds, and do not wrap
+ * around. That means the inserts always go to the right edge of the index
+ * (which is the best case for locality, but the index can't reuse space
+ * freed by deleting old rows by wrapping around). The main purpose is to
+ * produce UUIDs ordered consistently with UUIDv7 generated elsewhere.
+ */
+Datum
+uuid_time_nextval_v7(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+
+	generator_params_init(&params, GENERATOR_TIME, InvalidOid, 1, 1);
+	params.interval_unit = USECS_PER_SEC / 1000;
+	params.version = 7;
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_time_nextval_v8
+ *	generate sequential UUID using current time, marked as UUIDv8
+ *
+ * Works just like uuid_time_nextval (with the same wrap-around layout),
+ * except that the UUIDs are marked as version 8 (custom layout), instead
+ * of claiming to be random (version 4).
+ */
+Datum
+uuid_time_nextval_v8(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+
+	generator_params_init(&params, GENERATOR_TIME, InvalidOid,
+						  PG_GETARG_INT32(0), PG_GETARG_INT32(1));
+	params.version = 8;
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_counter_nextval
+ *	generate sequential UUID using a counter in shared memory
+ *
+ * Works just like uuid_sequence_nextval, except that the values come from
+ * a named counter in shared memory instead of a sequence. That means there
+ * is no buffer locking nor WAL, incrementing the counter is a single atomic
+ * operation. The counters are created on first use, persisted at shutdown
+ * and seeded from current time after a crash.
+ *
+ * Requires the library to be loaded through shared_preload_libraries.
+ */
+Datum
+uuid_counter_nextval(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+	char			   *name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+
+	generator_params_init(&params, GENERATOR_COUNTER, InvalidOid,
+						  PG_GETARG_INT32(1), PG_GETARG_INT32(2));
+
+	if (strlen(name) >= NAMEDATALEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_NAME_TOO_LONG),
+				 errmsg("counter name \"%s\" is too long", name)));
+
+	strlcpy(params.counter_name, name, NAMEDATALEN);
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_counter_lease
+ *	lease a range of sequence values to a shared counter
+ *
+ * Sequences can't be used in parallel mode (neither by the workers nor by
+ * the leader), so uuid_sequence_nextval is parallel unsafe. But a range of
+ * values may be reserved from the sequence before running a parallel
+ * query, and then handed out by uuid_counter_nextval (which is parallel
+ * safe), e.g.
+ *
+ *	 SELECT uuid_counter_lease('load', 's', 1000000);
+ *	 CREATE TABLE t AS SELECT uuid_counter_nextval('load'), ... FROM ...;
+ *
+ * The UUIDs then share the key space with UUIDs generated from the sequence
+ * by uuid_sequence_nextval (with the same block_size/block_count).
+ *
+ * The range is reserved atomically (waiting for concurrent transactions
+ * using the sequence to finish), which requires a sequence without CACHE.
+ * We can't wait when this transaction already fetched values from the
+ * sequence, because the lock we already hold conflicts with other sessions
+ * doing the same thing - each would wait for the other to finish. So in
+ * that case we only try to get the lock, and fail if it's not available.
+ *
+ * The counter has to be a new one - leasing values to a counter already
+ * handing out other values would break the uniqueness of the values. The
+ * counter hands out values from the lowest value of the range (it's
+ * incremented by 1, even with negative sequence increments), and fails
+ * after handing out nvalues values, so it never gets outside the range.
+ *
+ * Returns the first value handed out by the counter.
+ */
+Datum
+uuid_counter_lease(PG_FUNCTION_ARGS)
+{
+	char			   *name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	Oid					relid = PG_GETARG_OID(1);
+	int32				nvalues = PG_GETARG_INT32(2);
+	LOCKTAG				tag;
+	bool				wait;
+	bool				exists;
+	int64				first;
+	int64				last;
+	int64				increment;
+	int64				limit;
+
+	if (strlen(name) >= NAMEDATALEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_NAME_TOO_LONG),
+				 errmsg("counter name \"%s\" is too long", name)));
+
+	if (nvalues < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of values must be a positive integer")));
+
+	check_shared_state();
+
+	/* don't reserve anything if we can't use the counter anyway */
+	LWLockAcquire(shared->lock, LW_SHARED);
+	exists = (shared_counter_find(name) != NULL);
+	LWLockRelease(shared->lock);
+
+	if (exists)
+		ereport(ERROR,
+				(errcode(ERRCODE_DUPLICATE_OBJECT),
+				 errmsg("shared counter \"%s\" already exists", name),
+				 errhint("Lease the values to a new counter.")));
+
+	check_sequence_access(relid);
+
+	/* waiting while holding RowExclusiveLock (from nextval) may deadlock */
+	SET_LOCKTAG_RELATION(tag, MyDatabaseId, relid);
+	wait = !LockHeldByMeCompat(&tag, RowExclusiveLock);
+
+	increment = 1;
+	if (!sequence_reserve_range(relid, nvalues, wait, &first, &increment) &&
+		nvalues > 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_SEQUENCE_GENERATOR_LIMIT_EXCEEDED),
+				 errmsg("could not reserve %d values from sequence \"%s\"",
+						nvalues, get_rel_name(relid)),
+				 wait ?
+				 errhint("The sequence must not use CACHE, and the range must not exceed the sequence limits.") :
+				 errhint("The sequence must not use CACHE, and must not be used by other transactions when it was already used in this one.")));
+
+	/*
+	 * The counter hands out values upwards, starting at the lowest value.
+	 * The increment is at least 1, so the range spans at least nvalues
+	 * values. PG_INT64_MAX means "not leased", so a range ending right at
+	 * that value loses one value.
+	 */
+	last = first + (int64) (nvalues - 1) * increment;
+	first = Min(first, last);
+
+	if (first > PG_INT64_MAX - nvalues)
+		limit = PG_INT64_MAX - 1;
+	else
+		limit = first + nvalues;
+
+	LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+	if (shared_counter_find(name) != NULL)
+	{
+		LWLockRelease(shared->lock);
+		ereport(ERROR,
+				(errcode(ERRCODE_DUPLICATE_OBJECT),
+				 errmsg("shared counter \"%s\" already exists", name),
+				 errhint("Lease the values to a new counter.")));
+	}
+
+	(void) shared_counter_add(name, (uint64) first, limit);
+
+	LWLockRelease(shared->lock);
+
+	PG_RETURN_INT64(first);
+}
+
+/*
+ * uuid_time_block
+ *	extract block ID from an UUID generated by a time-based generator
+ *
+ * The parameters (and the node ID and stripes settings) need to match the
+ * ones used to generate the UUID, otherwise the result is meaningless.
+ */
+Datum
+uuid_time_block(PG_FUNCTION_ARGS)
+{
+	pg_uuid_t		   *uuid = PG_GETARG_UUID_P(0);
+	GeneratorParams		params;
+	SeqUUIDGenerator	gen;
+
+	generator_params_init(&params, GENERATOR_TIME, InvalidOid,
+						  PG_GETARG_INT32(1), PG_GETARG_INT32(2));
+
+	check_time_params(params.block_size, params.block_count);
+
+	generator_layout(&gen, &params);
+
+	PG_RETURN_INT32((int32) squuid_get_bits(uuid->data,
+											gen.layout.prefix_offset,
+											gen.layout.prefix_bits));
+}
+
+/*
+ * uuid_sequence_block
+ *	extract block ID from an UUID generated by a sequence-based generator
+ *
+ * Works for counter-based generators too, as they use the same layout.
+ * The block size does not affect the layout, so only the number of blocks
+ * is needed.
+ */
+Datum
+uuid_sequence_block(PG_FUNCTION_ARGS)
+{
+	pg_uuid_t		   *uuid = PG_GETARG_UUID_P(0);
+	GeneratorParams		params;
+	SeqUUIDGenerator	gen;
+
+	generator_params_init(&params, GENERATOR_SEQUENCE, InvalidOid,
+						  1, PG_GETARG_INT32(1));
+
+	check_sequence_params(params.block_size, params.block_count);
+
+	generator_layout(&gen, &params);
+
+	PG_RETURN_INT32((int32) squuid_get_bits(uuid->data,
+											gen.layout.prefix_offset,
+											gen.layout.prefix_bits));
+}
+
+/*
+ * uuid_block
+ *	extract block ID from an UUID, with the layout passed explicitly
+ *
+ * uuid_time_block and uuid_sequence_block take the node ID and stripes
+ * from the current settings, so they can't be immutable. But the block ID
+ * position depends only on the number of blocks and the number of node ID
+ * bytes placed before it, which the caller passes here. So this can be
+ * used in expression indexes, or for UUIDs generated with a different
+ * configuration.
+ */
+Datum
+uuid_block(PG_FUNCTION_ARGS)
+{
+	pg_uuid_t		   *uuid = PG_GETARG_UUID_P(0);
+	int32				block_count = PG_GETARG_INT32(1);
+	int32				node_bytes = PG_GETARG_INT32(2);
+
+	check_sequence_params(1, block_count);
+
+	if (node_bytes < 0 || node_bytes > 2)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of node ID bytes must be between 0 and 2")));
+
+	PG_RETURN_INT32((int32) squuid_get_bits(uuid->data, 8 * node_bytes,
+											squuid_bits_for_count(block_count)));
+}
+
+/*
+ * State of uuid_time_block_ranges, enumerating the candidate intervals.
+ */
+typedef struct BlockRangesState
+{
+	int64			next;			/* next interval (since Unix epoch) */
+	int64			last;			/* last interval to consider */
+	int64			step;			/* intervals between occurrences */
+	int64			length;			/* interval length (microseconds) */
+	TypeCacheEntry *typcache;		/* tstzrange */
+} BlockRangesState;
+
+/*
+ * uuid_time_block_ranges
+ *	list time intervals with the given block ID, between two timestamps
+ *
+ * The block ID wraps around after interval_count intervals, so a block ID
+ * does not identify a single time interval. But given a time period (e.g.
+ * the expected lifetime of the data), there's only a limited number of
+ * candidate intervals, which this function returns (as tstzrange values).
+ * Each returned interval overlaps with the [from, to) period.
+ */
+Datum
+uuid_time_block_ranges(PG_FUNCTION_ARGS)
+{
+	FuncCallContext	   *funcctx;
+	BlockRangesState   *state;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext	oldcontext;
+		int32			block = PG_GETARG_INT32(0);
+		TimestampTz		from = PG_GETARG_TIMESTAMPTZ(1);
+		TimestampTz		to = PG_GETARG_TIMESTAMPTZ(2);
+		int32			interval_length = PG_GETARG_INT32(3);
+		int32			interval_count = PG_GETARG_INT32(4);
+		int64			first;
+
+		check_time_params(interval_length, interval_count);
+
+		if (block < 0 || block >= interval_count)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("block ID must be between 0 and %d",
+							interval_count - 1)));
+
+		if (TIMESTAMP_NOT_FINITE(from) || TIMESTAMP_NOT_FINITE(to))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("timestamp out of range")));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		state = palloc(sizeof(BlockRangesState));
+
+		state->length = (int64) interval_length * USECS_PER_SEC;
+		state->step = interval_count;
+		state->typcache = lookup_type_cache(TSTZRANGEOID, TYPECACHE_RANGE_INFO);
+
+		/* first interval overlapping the period, and the matching one */
+		first = floor_div(timestamp_to_unix_usec(from), state->length);
+
+		state->next = first + ((block - first % interval_count) +
+							   interval_count) % interval_count;
+
+		/* last interval overlapping the period (which is exclusive) */
+		state->last = floor_div(timestamp_to_unix_usec(to) - 1, state->length);
+
+		funcctx->user_fctx = state;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = (BlockRangesState *) funcctx->user_fctx;
+
+	if (state->next <= state->last)
+	{
+		RangeBound	lower;
+		RangeBound	upper;
+		RangeType  *range;
+
+		lower.val = TimestampTzGetDatum(unix_usec_to_timestamp(state->next * state->length));
+		lower.infinite = false;
+		lower.inclusive = true;
+		lower.lower = true;
+
+		upper.val = TimestampTzGetDatum(unix_usec_to_timestamp((state->next + 1) * state->length));
+		upper.infinite = false;
+		upper.inclusive = false;
+		upper.lower = false;
+
+#if PG_VERSION_NUM >= 160000
+		range = make_range(state->typcache, &lower, &upper, false, NULL);
+#else
+		range = make_range(state->typcache, &lower, &upper, false);
+#endif
+
+		state->next += state->step;
+
+		SRF_RETURN_NEXT(funcctx, RangeTypePGetDatum(range));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * uuid_block_bound
+ *	smallest UUID with the given block ID
+ *
+ * The block may be equal to block_count, producing the upper bound of the
+ * last block. Useful for defining key ranges of blocks, e.g. partitions.
+ */
+Datum
+uuid_block_bound(PG_FUNCTION_ARGS)
+{
+	int32		block = PG_GETARG_INT32(0);
+	int32		block_count = PG_GETARG_INT32(1);
+	pg_uuid_t  *uuid;
+
+	check_block_prefix();
+
+	if (block_count < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of blocks must be a positive integer")));
+
+	if (block < 0 || block > block_count)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("block ID must be between 0 and %d", block_count)));
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	uuid_set_block_bound(uuid, block, squuid_bits_for_count(block_count));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_time_bound
+ *	bound of the key range of the block the timestamp belongs to
+ */
+static Datum
+uuid_time_bound(TimestampTz ts, int32 interval_length, int32 interval_count,
+				bool upper)
+{
+	int64		first;
+	int64		last;
+	pg_uuid_t  *uuid;
+
+	check_block_prefix();
+	check_time_params(interval_length, interval_count);
+
+	if (TIMESTAMP_NOT_FINITE(ts))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("timestamp out of range")));
+
+	/* the block of the interval containing the timestamp */
+	time_block_span(ts, ts + 1, interval_length, interval_count,
+					&first, &last);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	uuid_set_block_bound(uuid, upper ? (first + 1) : first,
+						 squuid_bits_for_count(interval_count));
+
+	return UUIDPGetDatum(uuid);
+}
+
+/*
+ * uuid_time_lower_bound
+ *	smallest UUID generated by a time-based generator at the given time
+ *
+ * All UUIDs generated during the interval containing the timestamp are
+ * greater or equal to this value (and less than uuid_time_upper_bound).
+ * Only the block ID matters, so this works for all time-based generators
+ * with the interval length in seconds, and any node ID or stripes.
+ */
+Datum
+uuid_time_lower_bound(PG_FUNCTION_ARGS)
+{
+	return uuid_time_bound(PG_GETARG_TIMESTAMPTZ(0), PG_GETARG_INT32(1),
+						   PG_GETARG_INT32(2), false);
+}
+
+/*
+ * uuid_time_upper_bound
+ *	exclusive upper bound of UUIDs generated at the given time
+ */
+Datum
+uuid_time_upper_bound(PG_FUNCTION_ARGS)
+{
+	return uuid_time_bound(PG_GETARG_TIMESTAMPTZ(0), PG_GETARG_INT32(1),
+						   PG_GETARG_INT32(2), true);
+}
+
+/*
+ * uuid_time_ranges
+ *	key ranges of UUIDs generated during a time period
+ *
+ * Returns (lower, upper) pairs, so that all UUIDs generated during the
+ * [from, to) period satisfy (id >= lower AND id < upper) for one of them.
+ * The period maps to a contiguous range of block IDs, but that may wrap
+ * around, in which case there are two key ranges. The ranges match UUIDs
+ * generated in all the earlier (or later) cycles too.
+ */
+Datum
+uuid_time_ranges(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	pg_uuid_t	   *bounds;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext	oldcontext;
+		TupleDesc		tupdesc;
+		TimestampTz		from = PG_GETARG_TIMESTAMPTZ(0);
+		TimestampTz		to = PG_GETARG_TIMESTAMPTZ(1);
+		int32			interval_length = PG_GETARG_INT32(2);
+		int32			interval_count = PG_GETARG_INT32(3);
+		int				prefix_bits;
+		int64			first;
+		int64			last;
+
+		check_block_prefix();
+		check_time_params(interval_length, interval_count);
+
+		if (TIMESTAMP_NOT_FINITE(from) || TIMESTAMP_NOT_FINITE(to))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("timestamp out of range")));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		/* at most two ranges, each with a lower and upper bound */
+		bounds = palloc(4 * sizeof(pg_uuid_t));
+		prefix_bits = squuid_bits_for_count(interval_count);
+
+		if (!time_block_span(from, to, interval_length, interval_count,
+							 &first, &last))
+			funcctx->max_calls = 0;
+		else if (first <= last)
+		{
+			uuid_set_block_bound(&bounds[0], first, prefix_bits);
+			uuid_set_block_bound(&bounds[1], last + 1, prefix_bits);
+			funcctx->max_calls = 1;
+		}
+		else
+		{
+			uuid_set_block_bound(&bounds[0], first, prefix_bits);
+			uuid_set_block_bound(&bounds[1], interval_count, prefix_bits);
+			uuid_set_block_bound(&bounds[2], 0, prefix_bits);
+			uuid_set_block_bound(&bounds[3], last + 1, prefix_bits);
+			funcctx->max_calls = 2;
+		}
+
+		funcctx->user_fctx = bounds;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	bounds = (pg_uuid_t *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		Datum		values[2];
+		bool		nulls[2] = {false, false};
+		HeapTuple	tuple;
+
+		values[0] = UUIDPGetDatum(&bounds[2 * funcctx->call_cntr]);
+		values[1] = UUIDPGetDatum(&bounds[2 * funcctx->call_cntr + 1]);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * uuid_time_within
+ *	check if the UUID was (possibly) generated during the time period
+ *
+ * True if the block ID of the UUID matches one of the intervals in the
+ * [from, to) period. On PostgreSQL 12+ the planner support function turns
+ * this into a range condition on the UUID, so it can use a B-tree index.
+ */
+Datum
+uuid_time_within(PG_FUNCTION_ARGS)
+{
+	pg_uuid_t  *uuid = PG_GETARG_UUID_P(0);
+	TimestampTz	from = PG_GETARG_TIMESTAMPTZ(1);
+	TimestampTz	to = PG_GETARG_TIMESTAMPTZ(2);
+	int32		interval_length = PG_GETARG_INT32(3);
+	int32		interval_count = PG_GETARG_INT32(4);
+	int64		block;
+	int64		first;
+	int64		last;
+
+	check_block_prefix();
+	check_time_params(interval_length, interval_count);
+
+	if (TIMESTAMP_NOT_FINITE(from) || TIMESTAMP_NOT_FINITE(to))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("timestamp out of range")));
+
+	if (!time_block_span(from, to, interval_length, interval_count,
+						 &first, &last))
+		PG_RETURN_BOOL(false);
+
+	block = squuid_get_bits(uuid->data, 0,
+							squuid_bits_for_count(interval_count));
+
+	if (first <= last)
+		PG_RETURN_BOOL(block >= first && block <= last);
+
+	PG_RETURN_BOOL(block >= first || block <= last);
+}
+
+/*
+ * uuid_time_within_support
+ *	planner support function for uuid_time_within
+ *
+ * Derives (id >= lower AND id < upper) index conditions, if all arguments
+ * except the UUID are constants and the period maps to a single key range
+ * (i.e. the block IDs don't wrap around). The conditions are lossy, so
+ * the function itself is still evaluated as a filter.
+ *
+ * On releases before PostgreSQL 12 there are no support functions, and
+ * this is never called.
+ */
+Datum
+uuid_time_within_support(PG_FUNCTION_ARGS)
+{
+#if PG_VERSION_NUM >= 120000
+	Node	   *rawreq = (Node *) PG_GETARG_POINTER(0);
+	SupportRequestIndexCondition *req;
+	FuncExpr   *clause;
+	Const	   *args[4];
+	int			i;
+	int64		first;
+	int64		last;
+	int32		interval_length;
+	int32		interval_count;
+	TimestampTz	from;
+	TimestampTz	to;
+	int			prefix_bits;
+	pg_uuid_t  *lower;
+	pg_uuid_t  *upper;
+	Oid			ge_opno;
+	Oid			lt_opno;
+	Expr	   *ge;
+	Expr	   *lt;
+
+	if (!IsA(rawreq, SupportRequestIndexCondition))
+		PG_RETURN_POINTER(NULL);
+
+	req = (SupportRequestIndexCondition *) rawreq;
+
+	if (!is_funcclause(req->node) || req->indexarg != 0 ||
+		req->index->relam != BTREE_AM_OID)
+		PG_RETURN_POINTER(NULL);
+
+	/* same check as in check_block_prefix, but without the error */
+	if (node_id >= 0 && node_id_first)
+		PG_RETURN_POINTER(NULL);
+
+	clause = (FuncExpr *) req->node;
+
+	if (list_length(clause->args) != 5)
+		PG_RETURN_POINTER(NULL);
+
+	/* all arguments except for the UUID have to be non-NULL constants */
+	for (i = 0; i < 4; i++)
+	{
+		Node	   *arg = (Node *) list_nth(clause->args, i + 1);
+
+		if (!IsA(arg, Const) || ((Const *) arg)->constisnull)
+			PG_RETURN_POINTER(NULL);
+
+		args[i] = (Const *) arg;
+	}
+
+	from = DatumGetTimestampTz(args[0]->constvalue);
+	to = DatumGetTimestampTz(args[1]->constvalue);
+	interval_length = DatumGetInt32(args[2]->constvalue);
+	interval_count = DatumGetInt32(args[3]->constvalue);
+
+	if (interval_length < 1 || interval_count < 1 ||
+		TIMESTAMP_NOT_FINITE(from) || TIMESTAMP_NOT_FINITE(to))
+		PG_RETURN_POINTER(NULL);
+
+	if (!time_block_span(from, to, interval_length, interval_count,
+						 &first, &last) || first > last)
+		PG_RETURN_POINTER(NULL);
+
+	ge_opno = get_opfamily_member(req->opfamily, UUIDOID, UUIDOID,
+								  BTGreaterEqualStrategyNumber);
+	lt_opno = get_opfamily_member(req->opfamily, UUIDOID, UUIDOID,
+								  BTLessStrategyNumber);
+
+	if (!OidIsValid(ge_opno) || !OidIsValid(lt_opno))
+		PG_RETURN_POINTER(NULL);
+
+	prefix_bits = squuid_bits_for_count(interval_count);
+
+	lower = palloc(sizeof(pg_uuid_t));
+	upper = palloc(sizeof(pg_uuid_t));
+
+	uuid_set_block_bound(lower, first, prefix_bits);
+	uuid_set_block_bound(upper, last + 1, prefix_bits);
+
+	ge = make_opclause(ge_opno, BOOLOID, false,
+					   (Expr *) linitial(clause->args),
+					   (Expr *) makeConst(UUIDOID, -1, InvalidOid, UUID_LEN,
+										  UUIDPGetDatum(lower), false, false),
+					   InvalidOid, InvalidOid);
+
+	lt = make_opclause(lt_opno, BOOLOID, false,
+					   (Expr *) linitial(clause->args),
+					   (Expr *) makeConst(UUIDOID, -1, InvalidOid, UUID_LEN,
+										  UUIDPGetDatum(upper), false, false),
+					   InvalidOid, InvalidOid);
+
+	req->lossy = true;
+
+	PG_RETURN_POINTER(list_make2(ge, lt));
+#else
+	PG_RETURN_POINTER(NULL);
+#endif
+}
+
+/*
+ * prewarm_sighup
+ *	SIGHUP handler of the prewarm worker (reload configuration)
+ */
+static void
+prewarm_sighup(SIGNAL_ARGS)
+{
+	int		save_errno = errno;
+
+	got_sighup = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * prewarm_index_range
+ *	read index leaf pages covering a range of UUID keys
+ *
+ * Performs an index-only walk of the [lower, upper) range, without fetching
+ * anything from the heap, so only the index pages get loaded into shared
+ * buffers. Indexes that don't exist or are not B-tree indexes on UUID are
+ * skipped with a warning.
+ */
+static void
+prewarm_index_range(const char *name, pg_uuid_t *lower, pg_uuid_t *upper)
+{
+	List		   *names;
+	Oid				indexoid;
+	Relation		index;
+	Relation		heap;
+	IndexScanDesc	scan;
+	ScanKeyData		keys[2];
+	int64			ntids = 0;
+
+#if PG_VERSION_NUM >= 160000
+	names = stringToQualifiedNameList(name, NULL);
+#else
+	names = stringToQualifiedNameList(name);
+#endif
+
+	indexoid = RangeVarGetRelid(makeRangeVarFromNameList(names),
+								AccessShareLock, true);
+
+	if (!OidIsValid(indexoid))
+	{
+		ereport(WARNING,
+				(errmsg("index \"%s\" does not exist, skipping prewarm", name)));
+		return;
+	}
+
+	if (get_rel_relkind(indexoid) != RELKIND_INDEX)
+	{
+		ereport(WARNING,
+				(errmsg("\"%s\" is not an index, skipping prewarm", name)));
+		return;
+	}
+
+	index = index_open(indexoid, NoLock);
+
+	if (index->rd_rel->relam != BTREE_AM_OID ||
+		index->rd_opcintype[0] != UUIDOID)
+	{
+		ereport(WARNING,
+				(errmsg("index \"%s\" is not a B-tree index on UUID, skipping prewarm",
+						name)));
+		index_close(index, AccessShareLock);
+		return;
+	}
+
+	heap = relation_open(index->rd_index->indrelid, AccessShareLock);
+
+	ScanKeyInit(&keys[0], 1, BTGreaterEqualStrategyNumber, F_UUID_GE,
+				UUIDPGetDatum(lower));
+	ScanKeyInit(&keys[1], 1, BTLessStrategyNumber, F_UUID_LT,
+				UUIDPGetDatum(upper));
+
+#if PG_VERSION_NUM >= 180000
+	scan = index_beginscan(heap, index, GetActiveSnapshot(), NULL, 2, 0);
+#else
+	scan = index_beginscan(heap, index, GetActiveSnapshot(), 2, 0);
+#endif
+
+	index_rescan(scan, keys, 2, NULL, 0);
+
+	while (index_getnext_tid(scan, ForwardScanDirection) != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+		ntids++;
+	}
+
+	index_endscan(scan);
+
+	relation_close(heap, AccessShareLock);
+	index_close(index, AccessShareLock);
+
+	elog(DEBUG1, "prewarmed index \"%s\" (" INT64_FORMAT " entries)",
+		 name, ntids);
+}
+
+/*
+ * prewarm_block
+ *	prewarm all the configured indexes for the given block
+ */
+static void
+prewarm_block(int64 block)
+{
+	char	   *rawnames;
+	List	   *names;
+	ListCell   *lc;
+	pg_uuid_t	lower;
+	pg_uuid_t	upper;
+	int			prefix_bits = squuid_bits_for_count(prewarm_interval_count);
+
+	/* the block ranges exist only with block ID at the beginning */
+	if (node_id >= 0 && node_id_first)
+	{
+		ereport(WARNING,
+				(errmsg("prewarm is not supported with the node ID placed before the block ID")));
+		return;
+	}
+
+	uuid_set_block_bound(&lower, block, prefix_bits);
+	uuid_set_block_bound(&upper, block + 1, prefix_bits);
+
+	SetCurrentStatementStartTimestamp();
+	StartTransactionCommand();
+	PushActiveSnapshot(GetTransactionSnapshot());
+	pgstat_report_activity(STATE_RUNNING, "prewarming indexes");
+
+	rawnames = pstrdup(prewarm_indexes);
+
+	if (!SplitIdentifierString(rawnames, ',', &names))
+		ereport(WARNING,
+				(errmsg("invalid list syntax in parameter \"%s\"",
+						"sequential_uuids.prewarm_indexes")));
+	else
+	{
+		foreach(lc, names)
+		{
+			CHECK_FOR_INTERRUPTS();
+			prewarm_index_range((char *) lfirst(lc), &lower, &upper);
+		}
+	}
+
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+	pgstat_report_activity(STATE_IDLE, NULL);
+}
+
+/*
+ * sequential_uuids_prewarm_main
+ *	main loop of the index prewarm worker
+ *
+ * After a wrap-around, the key range of the next block contains old index
+ * pages, possibly evicted from shared buffers long ago. So shortly before
+ * the time-based generators switch to the next block (prewarm_lead_time
+ * before the interval starts), we read the leaf pages covering the next
+ * block's key range, so that the inserts don't have to wait for I/O.
+ */
+void
+sequential_uuids_prewarm_main(Datum main_arg)
+{
+	int64	prewarmed = -1;		/* last prewarmed interval */
+
+	pqsignal(SIGHUP, prewarm_sighup);
+	/* so that CHECK_FOR_INTERRUPTS exits even in the middle of a prewarm */
+	pqsignal(SIGTERM, die);
+
+	BackgroundWorkerUnblockSignals();
+
+#if PG_VERSION_NUM >= 110000
+	BackgroundWorkerInitializeConnection(prewarm_database, NULL, 0);
+#else
+	BackgroundWorkerInitializeConnection(prewarm_database, NULL);
+#endif
+
+	for (;;)
+	{
+		int64	length;
+		int64	now;
+		int64	next;
+		int64	prewarm_at;
+		int64	wait_usec;
+		int		rc;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (got_sighup)
+		{
+			got_sighup = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		length = (int64) prewarm_interval_length * USECS_PER_SEC;
+		now = timestamp_to_unix_usec(GetCurrentTimestamp());
+
+		/* the next interval, and when to prewarm it */
+		next = floor_div(now, length) + 1;
+		prewarm_at = next * length - (int64) prewarm_lead_time * USECS_PER_SEC;
+
+		if (now >= prewarm_at && prewarmed != next)
+		{
+			prewarm_block(next % prewarm_interval_count);
+			prewarmed = next;
+			continue;
+		}
+
+		/* wait until it's time to prewarm, or for the next interval */
+		if (prewarmed != next)
+			wait_usec = prewarm_at - now;
+		else
+			wait_usec = next * length - now;
+
+		rc = WaitLatch(MyLatch,
+					   WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   wait_usec / 1000 + 1,
+					   PG_WAIT_EXTENSION);
+
+		ResetLatch(MyLatch);
+
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+	}
+}
+
+/*
+ * uuid_adaptive_nextval
+ *	generate sequential UUID using an adaptive generator
+ *
+ * The block ID is advanced after generating block_target UUIDs, or after
+ * max_interval seconds, whichever comes first. The state is kept in shared
+ * memory (sharing the names with counters), so all backends use the same
+ * block. Requires the library to be loaded through shared_preload_libraries.
+ */
+Datum
+uuid_adaptive_nextval(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+	char			   *name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+
+	generator_params_init(&params, GENERATOR_ADAPTIVE, InvalidOid,
+						  PG_GETARG_INT32(1), PG_GETARG_INT32(3));
+
+	params.max_interval = PG_GETARG_INT32(2);
+
+	if (strlen(name) >= NAMEDATALEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_NAME_TOO_LONG),
+				 errmsg("counter name \"%s\" is too long", name)));
+
+	strlcpy(params.counter_name, name, NAMEDATALEN);
+
+	gen = generator_prepare(fcinfo->flinfo, &params);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_adaptive_state
+ *	current state of an adaptive generator
+ *
+ * Returns the current block number (not wrapped to block_count), number
+ * of UUIDs generated in the block, when the block started, and the
+ * estimated generation rate (UUIDs per second).
+ */
+Datum
+uuid_adaptive_state(PG_FUNCTION_ARGS)
+{
+	char		   *name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	SharedCounter  *counter;
+	TupleDesc		tupdesc;
+	Datum			values[4];
+	bool			nulls[4] = {false, false, false, false};
+	int64			block_start;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	counter = shared_counter_lookup(name);
+
+	SpinLockAcquire(&counter->mutex);
+
+	values[0] = Int64GetDatum((int64) pg_atomic_read_u64(&counter->value));
+	values[1] = Int64GetDatum(counter->block_uuids);
+	block_start = counter->block_start;
+	values[3] = Float8GetDatum(counter->rate);
+
+	SpinLockRelease(&counter->mutex);
+
+	if (block_start == 0)
+		nulls[2] = true;
+	else
+		values[2] = TimestampTzGetDatum(unix_usec_to_timestamp(block_start));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc),
+													  values, nulls)));
+}
+
+/*
+ * uuid_index_open
+ *	open a B-tree index on UUID (with AccessShareLock), to read its pages
+ */
+static Relation
+uuid_index_open(Oid indexoid)
+{
+	Relation	index;
+
+	if (get_rel_relkind(indexoid) != RELKIND_INDEX)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not an index", get_rel_name(indexoid))));
+
+	index = index_open(indexoid, AccessShareLock);
+
+	if (index->rd_rel->relam != BTREE_AM_OID ||
+		index->rd_opcintype[0] != UUIDOID)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("index \"%s\" is not a B-tree index on UUID",
+						RelationGetRelationName(index))));
+
+	/* reading the index contents requires access to the table */
+	if (pg_class_aclcheck(index->rd_index->indrelid, GetUserId(),
+						  ACL_SELECT) != ACLCHECK_OK)
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("permission denied for table %s",
+						get_rel_name(index->rd_index->indrelid))));
+
+	return index;
+}
+
+/*
+ * uuid_adaptive_skip_dense
+ *	mark blocks still densely occupied in an index as skipped
+ *
+ * After a wrap-around, the adaptive generator gets back to key ranges that
+ * may still contain a lot of entries (when the data is not deleted in the
+ * insertion order), so the inserts split the old pages instead of filling
+ * pages emptied by vacuum. So we read all leaf pages of the index, assign
+ * each page to the block of its first key, and compute the average fill
+ * of pages in each block. Blocks with the average fill above max_fill are
+ * then skipped by the generator (when switching to the next block), until
+ * the function is called again. Blocks without leaf pages are empty.
+ *
+ * If all blocks are dense, none of them is skipped (the generator has to
+ * use some block). The map is kept only in shared memory, and applies only
+ * to generators with the same block_count.
+ *
+ * Returns the number of skipped blocks.
+ */
+Datum
+uuid_adaptive_skip_dense(PG_FUNCTION_ARGS)
+{
+	char			   *name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	Oid					indexoid = PG_GETARG_OID(1);
+	double				max_fill = PG_GETARG_FLOAT8(2);
+	int32				block_count = PG_GETARG_INT32(3);
+	SharedCounter	   *counter;
+	Relation			index;
+	BufferAccessStrategy strategy;
+	BlockNumber			npages;
+	BlockNumber			blkno;
+	int					prefix_bits;
+	double			   *fill;
+	int32			   *pages;
+	uint8				map[SKIP_MAP_BLOCKS / 8];
+	int32				ndense = 0;
+	int32				i;
+
+	if (strlen(name) >= NAMEDATALEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_NAME_TOO_LONG),
+				 errmsg("counter name \"%s\" is too long", name)));
+
+	if (max_fill <= 0 || max_fill > 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("maximum fill must be between 0 and 1")));
+
+	check_sequence_params(1, block_count);
+
+	if (block_count > SKIP_MAP_BLOCKS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of blocks must not exceed %d", SKIP_MAP_BLOCKS)));
+
+	/* the block is determined from the leading bits of the keys */
+	check_block_prefix();
+
+	counter = shared_counter_lookup(name);
+
+	index = uuid_index_open(indexoid);
+
+	prefix_bits = squuid_bits_for_count(block_count);
+
+	fill = palloc0(block_count * sizeof(double));
+	pages = palloc0(block_count * sizeof(int32));
+
+	npages = RelationGetNumberOfBlocks(index);
+
+	strategy = GetAccessStrategy(BAS_BULKREAD);
+
+	/* skip the metapage */
+	for (blkno = 1; blkno < npages; blkno++)
+	{
+		Buffer			buf;
+		Page			page;
+		BTPageOpaque	opaque;
+
+		CHECK_FOR_INTERRUPTS();
+
+		buf = ReadBufferExtended(index, MAIN_FORKNUM, blkno, RBM_NORMAL,
+								 strategy);
+		LockBuffer(buf, BUFFER_LOCK_SHARE);
+
+		page = BufferGetPage(buf);
+
+		if (!PageIsNew(page))
+		{
+			opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+
+			if (P_ISLEAF(opaque) && !P_IGNORE(opaque) &&
+				PageGetMaxOffsetNumber(page) >= P_FIRSTDATAKEY(opaque))
+			{
+				IndexTuple	itup;
+				Datum		key;
+				bool		isnull;
+
+				itup = (IndexTuple) PageGetItem(page,
+												PageGetItemId(page, P_FIRSTDATAKEY(opaque)));
+				key = index_getattr(itup, 1, RelationGetDescr(index), &isnull);
+
+				if (!isnull)
+				{
+					int32	block;
+
+					block = (int32) squuid_get_bits(DatumGetUUIDP(key)->data,
+													0, prefix_bits);
+
+					/* the map is computed for block_count, not for the bits */
+					if (block < block_count)
+					{
+						fill[block] += 1.0 - (double) PageGetFreeSpace(page) /
+							(BLCKSZ - SizeOfPageHeaderData - sizeof(BTPageOpaqueData));
+						pages[block]++;
+					}
+				}
+			}
+		}
+
+		UnlockReleaseBuffer(buf);
+	}
+
+	FreeAccessStrategy(strategy);
+
+	index_close(index, AccessShareLock);
+
+	memset(map, 0, sizeof(map));
+
+	for (i = 0; i < block_count; i++)
+	{
+		if (pages[i] > 0 && fill[i] / pages[i] > max_fill)
+		{
+			map[i / 8] |= (1 << (i % 8));
+			ndense++;
+		}
+	}
+
+	/* some block has to remain available */
+	if (ndense >= block_count)
+	{
+		memset(map, 0, sizeof(map));
+		ndense = 0;
+	}
+
+	/*
+	 * The map is too large to copy while holding the spinlock, so disable
+	 * it first (the generator reads the map only with skip_count > 0). The
+	 * LWLock prevents concurrent updates of the same map.
+	 */
+	LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+	SpinLockAcquire(&counter->mutex);
+	counter->skip_count = 0;
+	SpinLockRelease(&counter->mutex);
+
+	memcpy(counter->skip_map, map, sizeof(map));
+
+	SpinLockAcquire(&counter->mutex);
+	counter->skip_blocks = block_count;
+	counter->skip_count = ndense;
+	SpinLockRelease(&counter->mutex);
+
+	LWLockRelease(shared->lock);
+
+	pfree(fill);
+	pfree(pages);
+
+	PG_RETURN_INT32(ndense);
+}
+
+/*
+ * named_generator_params
+ *	build generator parameters for a named generator of the given kind
+ *
+ * The counter-based and adaptive generators use the generator name as
+ * the name of the shared counter.
+ */
+static void
+named_generator_params(GeneratorParams *params, const char *name,
+					   const char *kind, int32 block_size, int32 block_count,
+					   Oid relid, int32 position_bytes, int32 max_interval)
+{
+	if (strlen(name) >= NAMEDATALEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_NAME_TOO_LONG),
+				 errmsg("generator name \"%s\" is too long", name)));
+
+	if (strcmp(kind, "sequence") == 0)
+	{
+		if (!OidIsValid(relid))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("sequence-based generator requires a sequence")));
+
+		generator_params_init(params, GENERATOR_SEQUENCE, relid,
+							  block_size, block_count);
+	}
+	else if (strcmp(kind, "time") == 0 || strcmp(kind, "time_ms") == 0)
+	{
+		generator_params_init(params, GENERATOR_TIME, InvalidOid,
+							  block_size, block_count);
+
+		if (strcmp(kind, "time_ms") == 0)
+			params->interval_unit = USECS_PER_SEC / 1000;
+	}
+	else if (strcmp(kind, "counter") == 0)
+		generator_params_init(params, GENERATOR_COUNTER, InvalidOid,
+							  block_size, block_count);
+	else if (strcmp(kind, "adaptive") == 0)
+	{
+		generator_params_init(params, GENERATOR_ADAPTIVE, InvalidOid,
+							  block_size, block_count);
+		params->max_interval = max_interval;
+	}
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("unknown generator kind \"%s\"", kind),
+				 errhint("Valid kinds are \"sequence\", \"time\", \"time_ms\", \"counter\" and \"adaptive\".")));
+
+	if (relid != InvalidOid && params->kind != GENERATOR_SEQUENCE)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("only sequence-based generators use a sequence")));
+
+	params->position_bytes = position_bytes;
+
+	if (params->kind == GENERATOR_COUNTER ||
+		params->kind == GENERATOR_ADAPTIVE)
+		strlcpy(params->counter_name, name, NAMEDATALEN);
+}
+
+/*
+ * named_generators_table
+ *	qualified name of the table with named generators (for SPI queries)
+ *
+ * The extension is relocatable, so we have to look up the schema. Also
+ * remembers OID of the table, so that we know which relcache invalidations
+ * to watch for. Has to be called after SPI_connect.
+ */
+static char *
+named_generators_table(void)
+{
+	bool	isnull;
+	char   *schema;
+
+	if (SPI_execute("SELECT n.nspname, c.oid"
+					"  FROM pg_catalog.pg_extension e"
+					"  JOIN pg_catalog.pg_namespace n ON (n.oid = e.extnamespace)"
+					"  JOIN pg_catalog.pg_class c ON (c.relnamespace = n.oid)"
+					" WHERE e.extname = 'sequential_uuids'"
+					"   AND c.relname = 'uuid_generators'",
+					true, 1) != SPI_OK_SELECT)
+		elog(ERROR, "failed to look up the uuid_generators table");
+
+	if (SPI_processed != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("extension \"sequential_uuids\" is not installed")));
+
+	schema = SPI_getvalue(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1);
+
+	generators_relid = DatumGetObjectId(SPI_getbinval(SPI_tuptable->vals[0],
+													  SPI_tuptable->tupdesc,
+													  2, &isnull));
+
+	return psprintf("%s.uuid_generators", quote_identifier(schema));
+}
+
+/*
+ * named_generators_invalidate
+ *	relcache callback, invalidating the cached named generators
+ */
+static void
+named_generators_invalidate(Datum arg, Oid relid)
+{
+	HASH_SEQ_STATUS		status;
+	NamedGenerator	   *entry;
+
+	if (OidIsValid(relid) && relid != generators_relid)
+		return;
+
+	hash_seq_init(&status, generators_hash);
+
+	while ((entry = (NamedGenerator *) hash_seq_search(&status)) != NULL)
+		entry->valid = false;
+}
+
+/*
+ * named_generator_load
+ *	load parameters of a named generator from the uuid_generators table
+ */
+static void
+named_generator_load(NamedGenerator *entry)
+{
+	Oid			argtypes[1] = {TEXTOID};
+	Datum		args[1];
+	HeapTuple	tuple;
+	TupleDesc	tupdesc;
+	bool		isnull;
+	char	   *kind;
+	Datum		relid;
+	int32		block_size;
+	int32		block_count;
+	int32		position_bytes;
+	int32		max_interval;
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	args[0] = CStringGetTextDatum(entry->name);
+
+	if (SPI_execute_with_args(psprintf("SELECT kind, block_size, block_count,"
+									   " sequence::pg_catalog.regclass::pg_catalog.oid,"
+									   " position_bytes, max_interval"
+									   " FROM %s WHERE name = $1",
+									   named_generators_table()),
+							  1, argtypes, args, NULL, true, 1) != SPI_OK_SELECT)
+		elog(ERROR, "failed to load generator \"%s\"", entry->name);
+
+	if (SPI_processed != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("generator \"%s\" does not exist", entry->name)));
+
+	tuple = SPI_tuptable->vals[0];
+	tupdesc = SPI_tuptable->tupdesc;
+
+	kind = SPI_getvalue(tuple, tupdesc, 1);
+
+	relid = SPI_getbinval(tuple, tupdesc, 4, &isnull);
+	if (isnull)
+		relid = ObjectIdGetDatum(InvalidOid);
+
+	/* the other columns are NOT NULL */
+	block_size = DatumGetInt32(SPI_getbinval(tuple, tupdesc, 2, &isnull));
+	block_count = DatumGetInt32(SPI_getbinval(tuple, tupdesc, 3, &isnull));
+	position_bytes = DatumGetInt32(SPI_getbinval(tuple, tupdesc, 5, &isnull));
+	max_interval = DatumGetInt32(SPI_getbinval(tuple, tupdesc, 6, &isnull));
+
+	named_generator_params(&entry->params, entry->name, kind,
+						   block_size, block_count, DatumGetObjectId(relid),
+						   position_bytes, max_interval);
+
+	SPI_finish();
+
+	entry->valid = true;
+	entry->prepared = false;
+}
+
+/*
+ * named_generator_lookup
+ *	get a prepared named generator, loading it from the table if needed
+ *
+ * The configuration options (node ID, stripes) may change independently
+ * of the table, so the parameters are refreshed on every call, and the
+ * generator is prepared again if they changed.
+ *
+ * The prepared generator is cached for the whole backend lifetime, so
+ * unlike fn_extra it outlives changes of the current user (SET ROLE) and
+ * of the privileges (REVOKE). So the permissions on the sequence have to
+ * be checked on every call, not just when preparing the generator.
+ */
+static SeqUUIDGenerator *
+named_generator_lookup(const char *name)
+{
+	NamedGenerator	   *entry;
+	GeneratorParams		params;
+	char				key[NAMEDATALEN];
+	bool				found;
+
+	if (strlen(name) >= NAMEDATALEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_NAME_TOO_LONG),
+				 errmsg("generator name \"%s\" is too long", name)));
+
+	if (generators_hash == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = NAMEDATALEN;
+		ctl.entrysize = sizeof(NamedGenerator);
+
+		generators_hash = hash_create("sequential_uuids named generators",
+									  16, &ctl, HASH_ELEM | HASH_BLOBS);
+
+		CacheRegisterRelcacheCallback(named_generators_invalidate, (Datum) 0);
+	}
+
+	memset(key, 0, NAMEDATALEN);
+	strlcpy(key, name, NAMEDATALEN);
+
+	entry = (NamedGenerator *) hash_search(generators_hash, key,
+										   HASH_ENTER, &found);
+
+	if (!found)
+	{
+		entry->valid = false;
+		entry->prepared = false;
+	}
+
+	if (!entry->valid)
+		named_generator_load(entry);
+
+	memcpy(&params, &entry->params, sizeof(GeneratorParams));
+	generator_params_settings(&params);
+
+	if (!entry->prepared ||
+		memcmp(&entry->gen.params, &params, sizeof(GeneratorParams)) != 0)
+	{
+		SeqUUIDGenerator   *gen = generator_prepare(NULL, &params);
+
+		memcpy(&entry->gen, gen, sizeof(SeqUUIDGenerator));
+		pfree(gen);
+
+		entry->prepared = true;
+	}
+	else if (params.kind == GENERATOR_SEQUENCE)
+		check_sequence_access(params.relid);
+
+	return &entry->gen;
+}
 
 /*
- * uuid_sequence_nextval
- *	generate sequential UUID using a sequence
+ * uuid_create_generator
+ *	define a named generator, stored in the uuid_generators table
  *
- * The sequence-based sequential UUID generator define the group size
- * and group count based on number of UUIDs generated.
+ * The parameters are validated by preparing the generator, so errors are
+ * reported when creating the generator rather than on the first use.
+ */
+Datum
+uuid_create_generator(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	char			   *name;
+	char			   *kind;
+	Oid					relid = InvalidOid;
+	Oid					argtypes[7] = {TEXTOID, TEXTOID, INT4OID, INT4OID,
+									   TEXTOID, INT4OID, INT4OID};
+	Datum				args[7];
+	char				nulls[7] = {' ', ' ', ' ', ' ', 'n', ' ', ' '};
+	int					i;
+
+	for (i = 0; i < 7; i++)
+	{
+		if (i != 4 && PG_ARGISNULL(i))
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+					 errmsg("only the sequence may be NULL")));
+	}
+
+	name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	kind = text_to_cstring(PG_GETARG_TEXT_PP(1));
+
+	if (!PG_ARGISNULL(4))
+		relid = PG_GETARG_OID(4);
+
+	named_generator_params(&params, name, kind,
+						   PG_GETARG_INT32(2), PG_GETARG_INT32(3), relid,
+						   PG_GETARG_INT32(5), PG_GETARG_INT32(6));
+
+	gen = generator_prepare(NULL, &params);
+	pfree(gen);
+
+	args[0] = PG_GETARG_DATUM(0);
+	args[1] = PG_GETARG_DATUM(1);
+	args[2] = PG_GETARG_DATUM(2);
+	args[3] = PG_GETARG_DATUM(3);
+	args[5] = PG_GETARG_DATUM(5);
+	args[6] = PG_GETARG_DATUM(6);
+
+	/*
+	 * Store the sequence by name, so that it survives dump/restore. The name
+	 * is always schema-qualified, so that the same sequence is used no matter
+	 * what search_path the generator is used with.
+	 */
+	if (OidIsValid(relid))
+	{
+		char   *seqname;
+
+		seqname = quote_qualified_identifier(get_namespace_name(get_rel_namespace(relid)),
+											 get_rel_name(relid));
+
+		args[4] = CStringGetTextDatum(seqname);
+		nulls[4] = ' ';
+	}
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	if (SPI_execute_with_args(psprintf("INSERT INTO %s (name, kind, block_size,"
+									   " block_count, sequence, position_bytes,"
+									   " max_interval)"
+									   " VALUES ($1, $2, $3, $4, $5, $6, $7)",
+									   named_generators_table()),
+							  7, argtypes, args, nulls, false, 0) != SPI_OK_INSERT)
+		elog(ERROR, "failed to create generator \"%s\"", name);
+
+	SPI_finish();
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * uuid_drop_generator
+ *	remove a named generator
  *
- * The block_size (65546 by default) determines the number of UUIDs with
- * the same prefix, and block_count (65536 by default) determines the
- * number of blocks before wrapping around to 0. This means that with
- * the default values, the generator wraps around every ~2B UUIDs.
+ * Returns false if there was no generator with the name.
+ */
+Datum
+uuid_drop_generator(PG_FUNCTION_ARGS)
+{
+	Oid			argtypes[1] = {TEXTOID};
+	Datum		args[1];
+	bool		found;
+
+	args[0] = PG_GETARG_DATUM(0);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	if (SPI_execute_with_args(psprintf("DELETE FROM %s WHERE name = $1",
+									   named_generators_table()),
+							  1, argtypes, args, NULL, false, 0) != SPI_OK_DELETE)
+		elog(ERROR, "failed to drop generator");
+
+	found = (SPI_processed > 0);
+
+	SPI_finish();
+
+	PG_RETURN_BOOL(found);
+}
+
+/*
+ * uuid_generate
+ *	generate sequential UUID using a named generator
+ */
+Datum
+uuid_generate(PG_FUNCTION_ARGS)
+{
+	char			   *name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	SeqUUIDGenerator   *gen;
+	pg_uuid_t		   *uuid;
+
+	gen = named_generator_lookup(name);
+
+	uuid = palloc(sizeof(pg_uuid_t));
+
+	generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+	PG_RETURN_UUID_P(uuid);
+}
+
+/*
+ * uuid_generators_invalidate
+ *	trigger on uuid_generators, invalidating the cached generators
  *
- * You may increase (or rather decrease) the parameters if needed, e.g,
- * by lowering the block size to 256, in wich case the cycle interval
- * is only 16M values.
+ * Changes to the table contents don't invalidate the relcache entry on
+ * their own, so we do that explicitly. The invalidation is sent to all
+ * backends at commit, and processed by named_generators_invalidate.
  */
 Datum
-uuid_sequence_nextval(PG_FUNCTION_ARGS)
+uuid_generators_invalidate(PG_FUNCTION_ARGS)
 {
-	int				i;
-	int64			val;
-	Oid				relid = PG_GETARG_OID(0);
-	int32			block_size = PG_GETARG_INT32(1);
-	int32			block_count = PG_GETARG_INT32(2);
-	int64			prefix_bytes;
-	pg_uuid_t	   *uuid;
-	unsigned char  *p;
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "not called by trigger manager");
+
+	CacheInvalidateRelcache(trigdata->tg_relation);
+
+	PG_RETURN_POINTER(NULL);
+}
+
+/*
+ * stats_kind_name
+ *	name of the generator kind, as reported in statistics
+ */
+static const char *
+stats_kind_name(StatsKey *key)
+{
+	switch ((GeneratorKind) key->kind)
+	{
+		case GENERATOR_SEQUENCE:
+			return "sequence";
+		case GENERATOR_TIME:
+			if (key->version == 7)
+				return "uuidv7";
+			return (key->interval_unit == 1000) ? "time_ms" : "time";
+		case GENERATOR_COUNTER:
+			return "counter";
+		case GENERATOR_ADAPTIVE:
+			return "adaptive";
+	}
+
+	return "unknown";
+}
+
+/*
+ * sequential_uuids_stats
+ *	return statistics of generators, for the sequential_uuids_stats view
+ *
+ * The shared entries are copied at the first call, so that we don't need
+ * to hold the lock while returning the rows. Statistics of the current
+ * backend are flushed first, so that they're included.
+ */
+Datum
+sequential_uuids_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	SharedStatsEntry *entries;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext		oldcontext;
+		TupleDesc			tupdesc;
+		HASH_SEQ_STATUS		status;
+		SharedStatsEntry   *sentry;
+		int					nentries = 0;
+
+		if (!shared || !shared_stats_hash)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("sequential_uuids must be loaded via shared_preload_libraries")));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		stats_flush();
+
+		LWLockAcquire(shared->lock, LW_SHARED);
+
+		entries = palloc(Max(hash_get_num_entries(shared_stats_hash), 1) *
+						 sizeof(SharedStatsEntry));
+
+		hash_seq_init(&status, shared_stats_hash);
+		while ((sentry = (SharedStatsEntry *) hash_seq_search(&status)) != NULL)
+		{
+			entries[nentries].key = sentry->key;
+
+			SpinLockAcquire(&sentry->mutex);
+			entries[nentries].counters = sentry->counters;
+			SpinLockRelease(&sentry->mutex);
+
+			nentries++;
+		}
+
+		LWLockRelease(shared->lock);
+
+		funcctx->user_fctx = entries;
+		funcctx->max_calls = nentries;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	entries = (SharedStatsEntry *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		SharedStatsEntry   *entry = &entries[funcctx->call_cntr];
+		Datum				values[13];
+		bool				nulls[13];
+		HeapTuple			tuple;
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[0] = CStringGetTextDatum(stats_kind_name(&entry->key));
+
+		if (OidIsValid(entry->key.relid))
+			values[1] = ObjectIdGetDatum(entry->key.relid);
+		else
+			nulls[1] = true;
+
+		if (entry->key.counter_name[0] != '\0')
+			values[2] = CStringGetTextDatum(entry->key.counter_name);
+		else
+			nulls[2] = true;
+
+		values[3] = Int32GetDatum(entry->key.block_size);
+		values[4] = Int32GetDatum(entry->key.block_count);
+		values[5] = Int64GetDatum(entry->counters.calls);
+		values[6] = Int64GetDatum(entry->counters.uuids);
+		values[7] = Int64GetDatum(entry->counters.random_bytes);
+		values[8] = Int64GetDatum(entry->counters.nextval_avoided);
+		values[9] = Int64GetDatum(entry->counters.block_transitions);
+		values[10] = Int64GetDatum(entry->counters.wraparounds);
+		values[11] = Float8GetDatum(entry->counters.random_time);
+		values[12] = Int32GetDatum(entry->key.version);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
 
-	/* some basic sanity checks */
-	if (block_size < 0)
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * sequential_uuids_stats_reset
+ *	discard statistics of all generators
+ */
+Datum
+sequential_uuids_stats_reset(PG_FUNCTION_ARGS)
+{
+	HASH_SEQ_STATUS		status;
+	SharedStatsEntry   *sentry;
+
+	if (!shared || !shared_stats_hash)
 		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				 errmsg("block size must be a positive integer")));
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("sequential_uuids must be loaded via shared_preload_libraries")));
 
-	if (block_count < 0)
+	LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+	hash_seq_init(&status, shared_stats_hash);
+	while ((sentry = (SharedStatsEntry *) hash_seq_search(&status)) != NULL)
+		hash_search(shared_stats_hash, &sentry->key, HASH_REMOVE, NULL);
+
+	LWLockRelease(shared->lock);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * bench_elapsed_ns
+ *	time elapsed since start, in nanoseconds per value
+ */
+static double
+bench_elapsed_ns(instr_time start, int64 nvalues)
+{
+	instr_time	duration;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+
+	return INSTR_TIME_GET_DOUBLE(duration) * 1e9 / Max(nvalues, 1);
+}
+
+/*
+ * sequential_uuids_bench
+ *	measure cost of the individual steps of generating a UUID
+ *
+ * Each step is executed nvalues times in a tight loop, so that the timing
+ * does not include the overhead of the executor and of reading the clock
+ * for each step. The results are in nanoseconds per UUID:
+ *
+ * - prepare: lookup of the generator cached in fn_extra
+ * - prepare_uncached: preparing the generator from scratch
+ * - clock: reading the current time (using the configured clock source)
+ * - sequence: getting the next value of the sequence/counter (not used
+ *   by the time-based generators)
+ * - random: generating the random bytes (using the configured source)
+ * - layout: stamping the layout fields into the UUID
+ * - alloc: allocating memory for the UUID
+ * - total: generating the UUIDs the same way the SQL functions do
+ *
+ * With batch_size > 0, random data, layout and allocation are done for
+ * batches of UUIDs, the same way as by the bulk/array functions.
+ *
+ * Note that the sequence is advanced, once by the sequence step and once
+ * by the total step. The counter-based and adaptive generators use a
+ * counter allocated in backend memory, so that the benchmark does not
+ * take one of the shared counters (which are never removed, and are
+ * persisted), and works without shared_preload_libraries. So the prepare
+ * steps don't include the lookup of the shared counter.
+ */
+Datum
+sequential_uuids_bench(PG_FUNCTION_ARGS)
+{
+	GeneratorParams		params;
+	SeqUUIDGenerator   *gen;
+	FmgrInfo			flinfo;
+	MemoryContext		benchcxt;
+	MemoryContext		oldcontext;
+	TupleDesc			tupdesc;
+	Datum				values[8];
+	bool				nulls[8];
+	instr_time			start;
+	volatile int64		sink = 0;
+	pg_uuid_t		   *uuids;
+	char			   *kind;
+	Oid					relid = InvalidOid;
+	int32				nvalues;
+	int32				batch_size;
+	int32				chunk;
+	int32				random_offset;
+	SharedCounter	   *counter;
+	int64				i;
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2) ||
+		PG_ARGISNULL(3) || PG_ARGISNULL(5))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("only the sequence may be NULL")));
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	kind = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	nvalues = PG_GETARG_INT32(1);
+	batch_size = PG_GETARG_INT32(5);
+
+	if (!PG_ARGISNULL(4))
+		relid = PG_GETARG_OID(4);
+
+	if (nvalues < 1)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				 errmsg("number of blocks must be a positive integer")));
+				 errmsg("number of values must be a positive integer")));
+
+	check_batch_size(batch_size);
+
+	named_generator_params(&params, "sequential_uuids_bench", kind,
+						   PG_GETARG_INT32(2), PG_GETARG_INT32(3), relid,
+						   0, 60);
+
+	if (batch_size > 0 &&
+		params.kind != GENERATOR_SEQUENCE && params.kind != GENERATOR_TIME)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("batches are supported only by sequence-based and time-based generators")));
+
+	counter = palloc(sizeof(SharedCounter));
+	shared_counter_init(counter, params.counter_name, counter_seed(0),
+						PG_INT64_MAX);
+
+	memset(&flinfo, 0, sizeof(FmgrInfo));
+	flinfo.fn_mcxt = CurrentMemoryContext;
+
+	gen = generator_prepare_with(&flinfo, &params, counter);
+
+	/* don't include the benchmark in statistics */
+	gen->stats = NULL;
+
+	chunk = Max(batch_size, 1);
+	random_offset = gen->layout.layout_bits / 8;
 
-	/* count the number of bytes to keep from the sequence value */
-	prefix_bytes = 0;
-	while (block_count > 1)
+	uuids = palloc(chunk * sizeof(pg_uuid_t));
+
+	benchcxt = AllocSetContextCreate(CurrentMemoryContext,
+									 "sequential_uuids bench",
+									 ALLOCSET_DEFAULT_SIZES);
+
+	memset(nulls, 0, sizeof(nulls));
+
+	/* prepare (cached) */
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nvalues; i++)
 	{
-		block_count /= 256;
-		prefix_bytes++;
+		if (generator_prepare_with(&flinfo, &params, counter) != gen)
+			elog(ERROR, "cached generator not reused");
 	}
+	values[0] = Float8GetDatum(bench_elapsed_ns(start, nvalues));
 
-	/*
-	 * Read the next value from the sequence and get rid of the least
-	 * significant bytes.
-	 */
-	val = nextval_internal(relid, true);
-	val /= block_size;
+	CHECK_FOR_INTERRUPTS();
 
-	p = (unsigned char *) &val;
+	/* prepare (uncached) */
+	oldcontext = MemoryContextSwitchTo(benchcxt);
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nvalues; i++)
+		pfree(generator_prepare_with(NULL, &params, counter));
+	values[1] = Float8GetDatum(bench_elapsed_ns(start, nvalues));
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(benchcxt);
 
-	uuid = palloc(sizeof(pg_uuid_t));
+	CHECK_FOR_INTERRUPTS();
 
-	/* copy the desired number of (least significant) bytes as prefix */
-	for (i = 0; i < prefix_bytes; i++)
-		uuid->data[i] = p[prefix_bytes - 1 - i];
+	/* clock */
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nvalues; i++)
+		sink += time_now_usec();
+	values[2] = Float8GetDatum(bench_elapsed_ns(start, nvalues));
 
-	/* generate the remaining bytes as random (use strong generator) */
-	if(!pg_strong_random(uuid->data + prefix_bytes, UUID_LEN - prefix_bytes))
-		ereport(ERROR,
-				(errcode(ERRCODE_INTERNAL_ERROR),
-				 errmsg("could not generate random values")));
+	CHECK_FOR_INTERRUPTS();
 
-	/*
-	 * Set the UUID version flags according to "version 4" (pseudorandom)
-	 * UUID, see http://tools.ietf.org/html/rfc4122#section-4.4
-	 *
-	 * This does reduce the randomness a bit, because it determines the
-	 * value of certain bits, but that should be negligible (certainly
-	 * compared to the reduction due to prefix).
-	 * 
-	 * UUID v4 is probably the safest choice here. There is v1 which is
-	 * time-based, but it includes MAC address (which we don't use) and
-	 * works with very special timestamp (starting at 1582 etc.). So we
-	 * just use v4 and claim this is pseudorandom.
-	 */
-	uuid->data[6] = (uuid->data[6] & 0x0f) | 0x40;	/* time_hi_and_version */
-	uuid->data[8] = (uuid->data[8] & 0x3f) | 0x80;	/* clock_seq_hi_and_reserved */
+	/* sequence (or counter) */
+	if (params.kind != GENERATOR_TIME)
+	{
+		INSTR_TIME_SET_CURRENT(start);
+		for (i = 0; i < nvalues; i++)
+			sink += generator_next_value(gen);
+		values[3] = Float8GetDatum(bench_elapsed_ns(start, nvalues));
+	}
+	else
+		nulls[3] = true;
 
-	PG_RETURN_UUID_P(uuid);
+	CHECK_FOR_INTERRUPTS();
+
+	/* random data */
+	INSTR_TIME_SET_CURRENT(start);
+	if (batch_size > 0)
+	{
+		for (i = 0; i < nvalues; i += chunk)
+			random_fill((unsigned char *) uuids,
+						Min(chunk, nvalues - i) * sizeof(pg_uuid_t));
+	}
+	else
+	{
+		for (i = 0; i < nvalues; i++)
+			random_fill(uuids->data + random_offset, UUID_LEN - random_offset);
+	}
+	values[4] = Float8GetDatum(bench_elapsed_ns(start, nvalues));
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* layout */
+	INSTR_TIME_SET_CURRENT(start);
+	if (batch_size > 0)
+	{
+		for (i = 0; i < nvalues; i += chunk)
+			generator_apply_run(gen, uuids, Min(chunk, nvalues - i), i);
+	}
+	else
+	{
+		for (i = 0; i < nvalues; i++)
+			squuid_stamp(&gen->layout, uuids->data, i);
+	}
+	values[5] = Float8GetDatum(bench_elapsed_ns(start, nvalues));
+
+	sink += uuids->data[0];
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* allocation (the context is reset regularly, like per-tuple memory) */
+	oldcontext = MemoryContextSwitchTo(benchcxt);
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nvalues; i += chunk)
+	{
+		pg_uuid_t  *uuid = palloc(Min(chunk, nvalues - i) * sizeof(pg_uuid_t));
+
+		sink += (int64) (uintptr_t) uuid;
+
+		if ((i / chunk) % 1024 == 1023)
+			MemoryContextReset(benchcxt);
+	}
+	values[6] = Float8GetDatum(bench_elapsed_ns(start, nvalues));
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(benchcxt);
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* total */
+	oldcontext = MemoryContextSwitchTo(benchcxt);
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nvalues; i += chunk)
+	{
+		pg_uuid_t  *uuid = palloc(Min(chunk, nvalues - i) * sizeof(pg_uuid_t));
+
+		if (batch_size > 0)
+			generator_make_batch(gen, uuid, Min(chunk, nvalues - i));
+		else
+			generator_make_uuid(gen, uuid, generator_next_value(gen));
+
+		sink += uuid->data[0];
+
+		if ((i / chunk) % 1024 == 1023)
+			MemoryContextReset(benchcxt);
+	}
+	values[7] = Float8GetDatum(bench_elapsed_ns(start, nvalues));
+	MemoryContextSwitchTo(oldcontext);
+
+	MemoryContextDelete(benchcxt);
+
+	(void) sink;
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc),
+													  values, nulls)));
 }
 
+/* maximum number of index pages sampled by sequential_uuids_recommend */
+#define RECOMMEND_SAMPLE_PAGES	1000
+
 /*
- * uuid_time_nextval
- *	generate sequential UUID using current time
+ * sequential_uuids_recommend
+ *	recommend generator parameters for an index and cache budget
  *
- * The timestamp-based sequential UUID generator define the group size
- * and group count based on data extracted from current timestamp.
+ * A block of UUIDs covers a part of the index key range, and while the
+ * block is active, the inserts are spread over leaf pages in that part.
+ * To keep those leaf pages cached, the block has to fit into the cache
+ * budget, including entries inserted into the same key range in previous
+ * cycles (before the wrap-around). So we split the budget in half - one
+ * half for UUIDs of the current block, the other one for older entries.
  *
- * The interval_length (60 seconds by default) is defined as number of
- * seconds where UUIDs share the same prefix). The prefix length is
- * determined by the number of intervals (65536 by default, i.e. 2B).
- * With these parameters the generator wraps around every ~45 days.
+ * The number of entries per leaf page is estimated by reading a sample
+ * of index pages (evenly spaced, using a ring buffer so that we don't
+ * pollute shared buffers). The number of existing entries is used as an
+ * estimate of the entries in the key range from past cycles, so the
+ * recommendation should be recomputed as the index grows.
+ *
+ * The number of blocks is rounded up to a power of two, so that all the
+ * block ID bits are used. The interval length (for time-based generators)
+ * is derived from the expected insert rate (UUIDs per second).
  */
 Datum
-uuid_time_nextval(PG_FUNCTION_ARGS)
+sequential_uuids_recommend(PG_FUNCTION_ARGS)
 {
-	int				i;
-	struct timeval	tv;
-	int64			val;
-	pg_uuid_t	   *uuid;
-	int32			interval_length = PG_GETARG_INT32(0);
-	int32			interval_count = PG_GETARG_INT32(1);
-	int64			prefix_bytes;
-	unsigned char  *p;
-
-	/* some basic sanity checks */
-	if (interval_length < 1)
+	Oid					indexoid = PG_GETARG_OID(0);
+	int64				cache_size = PG_GETARG_INT64(1);
+	double				rate = PG_GETARG_FLOAT8(2);
+	Relation			index;
+	BufferAccessStrategy strategy;
+	BlockNumber			npages;
+	BlockNumber			step;
+	BlockNumber			blkno;
+	int64				sampled = 0;
+	int64				leaves = 0;
+	int64				tuples = 0;
+	double				tuples_per_leaf;
+	double				leaf_pages;
+	double				entries;
+	double				budget;
+	double				block_size;
+	double				block_count;
+	double				interval_length;
+	double				wraparound;
+	double				days;
+	TupleDesc			tupdesc;
+	Datum				values[7];
+	bool				nulls[7] = {false, false, false, false, false, false, false};
+
+	if (cache_size < BLCKSZ)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				 errmsg("length of interval must be a positive integer")));
+				 errmsg("cache size must be at least %d bytes", BLCKSZ)));
 
-	if (interval_count < 1)
+	if (rate <= 0)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				 errmsg("number of intervals must be a positive integer")));
+				 errmsg("expected rate must be a positive number")));
 
-	if (gettimeofday(&tv, NULL) != 0)
-		elog(ERROR, "gettimeofday call failed");
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
 
-	val = (tv.tv_sec / interval_length);
+	index = uuid_index_open(indexoid);
 
-	/* count the number of bytes to keep from the timestamp */
-	prefix_bytes = 0;
-	while (interval_count > 1)
+	npages = RelationGetNumberOfBlocks(index);
+
+	strategy = GetAccessStrategy(BAS_BULKREAD);
+
+	/* skip the metapage */
+	step = Max((npages - 1) / RECOMMEND_SAMPLE_PAGES, 1);
+
+	for (blkno = 1; blkno < npages; blkno += step)
 	{
-		interval_count /= 256;
-		prefix_bytes++;
-	}
+		Buffer			buf;
+		Page			page;
+		BTPageOpaque	opaque;
 
-	p = (unsigned char *) &val;
+		CHECK_FOR_INTERRUPTS();
 
-	uuid = palloc(sizeof(pg_uuid_t));
+		buf = ReadBufferExtended(index, MAIN_FORKNUM, blkno, RBM_NORMAL,
+								 strategy);
+		LockBuffer(buf, BUFFER_LOCK_SHARE);
 
-	/* copy the desired number of (least significant) bytes as prefix */
-	for (i = 0; i < prefix_bytes; i++)
-		uuid->data[i] = p[prefix_bytes - 1 - i];
+		page = BufferGetPage(buf);
+		sampled++;
 
-	/* generate the remaining bytes as random (use strong generator) */
-	if(!pg_strong_random(uuid->data + prefix_bytes, UUID_LEN - prefix_bytes))
-		ereport(ERROR,
-				(errcode(ERRCODE_INTERNAL_ERROR),
-				 errmsg("could not generate random values")));
+		if (!PageIsNew(page))
+		{
+			opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+
+			if (P_ISLEAF(opaque) && !P_IGNORE(opaque))
+			{
+				leaves++;
+				tuples += PageGetMaxOffsetNumber(page) - P_FIRSTDATAKEY(opaque) + 1;
+			}
+		}
+
+		UnlockReleaseBuffer(buf);
+	}
+
+	FreeAccessStrategy(strategy);
+
+	index_close(index, AccessShareLock);
 
 	/*
-	 * Set the UUID version flags according to "version 4" (pseudorandom)
-	 * UUID, see http://tools.ietf.org/html/rfc4122#section-4.4
-	 *
-	 * This does reduce the randomness a bit, because it determines the
-	 * value of certain bits, but that should be negligible (certainly
-	 * compared to the reduction due to prefix).
-	 * 
-	 * UUID v4 is probably the safest choice here. There is v1 which is
-	 * time-based, but it includes MAC address (which we don't use) and
-	 * works with very special timestamp (starting at 1582 etc.). So we
-	 * just use v4 and claim this is pseudorandom.
+	 * For empty indexes, assume the leaf pages are about half full, which
+	 * is what random inserts lead to (a page holds ~400 UUIDs with 8kB
+	 * pages).
 	 */
-	uuid->data[6] = (uuid->data[6] & 0x0f) | 0x40;	/* time_hi_and_version */
-	uuid->data[8] = (uuid->data[8] & 0x3f) | 0x80;	/* clock_seq_hi_and_reserved */
+	if (leaves > 0 && tuples > 0)
+		tuples_per_leaf = (double) tuples / leaves;
+	else
+		tuples_per_leaf = (BLCKSZ - SizeOfPageHeaderData) /
+			(2.0 * (MAXALIGN(sizeof(IndexTupleData) + UUID_LEN) + sizeof(ItemIdData)));
 
-	PG_RETURN_UUID_P(uuid);
+	leaf_pages = (sampled > 0) ? (double) (npages - 1) * leaves / sampled : 0;
+	entries = leaf_pages * tuples_per_leaf;
+
+	/* number of entries fitting into half of the cache budget */
+	budget = Max(1.0, floor((double) (cache_size / BLCKSZ) * tuples_per_leaf / 2));
+
+	block_size = Min(budget, (double) PG_INT32_MAX);
+
+	/* enough blocks so that entries from past cycles fit into the budget */
+	block_count = 2;
+	while (block_count < entries / budget && block_count < ((int64) 1 << 30))
+		block_count *= 2;
+
+	interval_length = Min(Max(1.0, ceil(block_size / rate)), (double) PG_INT32_MAX);
+
+	values[0] = Int64GetDatum((int64) leaf_pages);
+	values[1] = Float8GetDatum(tuples_per_leaf);
+	values[2] = Int32GetDatum((int32) block_size);
+	values[3] = Int32GetDatum((int32) interval_length);
+	values[4] = Int32GetDatum((int32) block_count);
+	values[5] = Int64GetDatum((int64) block_size * (int64) block_count);
+
+	/* wrap-around period of the time-based generator */
+	wraparound = block_count * interval_length;
+	days = Min(floor(wraparound / SECS_PER_DAY), (double) PG_INT32_MAX);
+
+	values[6] = DirectFunctionCall7(make_interval,
+									Int32GetDatum(0), Int32GetDatum(0),
+									Int32GetDatum(0), Int32GetDatum((int32) days),
+									Int32GetDatum(0), Int32GetDatum(0),
+									Float8GetDatum(wraparound - days * SECS_PER_DAY));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc),
+													  values, nulls)));
 }
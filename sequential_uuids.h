@@ -0,0 +1,381 @@
+/*-------------------------------------------------------------------------
+ *
+ * sequential_uuids.h
+ *	  layout of sequential UUIDs, shared by the extension and clients
+ *
+ * This is a header-only implementation of the UUID layouts produced by
+ * the generators, used by the extension itself, and usable by client
+ * applications (C or C++) to generate UUIDs with the same layout, e.g.
+ * to assign keys before inserting the rows (without a round trip to get
+ * the generated key back). It depends only on the C standard library.
+ *
+ * The layout fields are stored in the UUID in big-endian order, so that
+ * the UUIDs sort by the block ID first. The caller provides the random
+ * data, and the value determining the block - for time-based generators
+ * that's the current time as microseconds since the Unix epoch, for the
+ * counter-based ones the counter value.
+ *
+ * For example, to generate UUIDs compatible with uuid_time_nextval():
+ *
+ *	SeqUUIDLayout	layout;
+ *	unsigned char	random[SQUUID_LEN];
+ *	unsigned char	uuid[SQUUID_LEN];
+ *
+ *	if (squuid_time_layout(&layout, 60, 65536) != 0)
+ *		... invalid parameters ...
+ *
+ *	... fill random with (cryptographically strong) random bytes ...
+ *	squuid_generate(&layout, uuid, now_usec, random);
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SEQUENTIAL_UUIDS_H
+#define SEQUENTIAL_UUIDS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* length of UUID (in bytes) */
+#define SQUUID_LEN			16
+
+/* number of leading bits available for the layout (before UUID version) */
+#define SQUUID_LAYOUT_BITS	48
+
+/*
+ * Layout of the UUID. It starts with the block ID, optionally followed by
+ * the stripe and the position within the block, and the remaining bits are
+ * random. The node ID (if any) is placed either before or right after the
+ * block ID. Offsets and lengths are in bits.
+ */
+typedef struct SeqUUIDLayout
+{
+	int64_t		block_length;	/* values (or microseconds) per block */
+	int64_t		block_count;	/* blocks before wrapping around */
+	int			version;		/* UUID version */
+	int			prefix_offset;	/* block ID */
+	int			prefix_bits;
+	int			node_offset;	/* node ID */
+	int			node_bits;
+	uint64_t	node_id;
+	int			stripe_offset;	/* stripe */
+	int			stripe_bits;
+	uint64_t	stripe;
+	int			position_offset;	/* position in block */
+	int			position_bits;
+	int			layout_bits;	/* total bits not filled with random data */
+} SeqUUIDLayout;
+
+/*
+ * squuid_set_bits
+ *	store the desired number of (least significant) bits of a value
+ *
+ * The value is stored in big-endian order, starting at the given bit
+ * offset, so that UUIDs sort by the value first. Bits outside the range
+ * are not modified.
+ */
+static inline void
+squuid_set_bits(unsigned char *uuid, int offset, uint64_t val, int nbits)
+{
+	while (nbits > 0)
+	{
+		int		byte = offset / 8;
+		int		used = offset % 8;	/* bits before offset in this byte */
+		int		n = (nbits < 8 - used) ? nbits : 8 - used;
+		uint8_t	mask = (uint8_t) (((1 << n) - 1) << (8 - used - n));
+		uint8_t	bits = (uint8_t) (((val >> (nbits - n)) << (8 - used - n)) & mask);
+
+		uuid[byte] = (uint8_t) ((uuid[byte] & ~mask) | bits);
+
+		offset += n;
+		nbits -= n;
+	}
+}
+
+/*
+ * squuid_get_bits
+ *	extract a value stored by squuid_set_bits
+ */
+static inline uint64_t
+squuid_get_bits(const unsigned char *uuid, int offset, int nbits)
+{
+	uint64_t	val = 0;
+
+	while (nbits > 0)
+	{
+		int		byte = offset / 8;
+		int		used = offset % 8;	/* bits before offset in this byte */
+		int		n = (nbits < 8 - used) ? nbits : 8 - used;
+		uint8_t	bits = (uint8_t) ((uuid[byte] >> (8 - used - n)) & ((1 << n) - 1));
+
+		val = (val << n) | bits;
+
+		offset += n;
+		nbits -= n;
+	}
+
+	return val;
+}
+
+/*
+ * squuid_bits_for_count
+ *	number of bits needed to store values 0 .. (count-1)
+ */
+static inline int
+squuid_bits_for_count(int64_t count)
+{
+	int		nbits = 0;
+
+	while (nbits < 62 && ((int64_t) 1 << nbits) < count)
+		nbits++;
+
+	return nbits;
+}
+
+/*
+ * squuid_set_version
+ *	set the UUID version and variant flags
+ *
+ * By default, set the UUID version flags according to "version 4"
+ * (pseudorandom) UUID, see http://tools.ietf.org/html/rfc4122#section-4.4
+ *
+ * This does reduce the randomness a bit, because it determines the
+ * value of certain bits, but that should be negligible (certainly
+ * compared to the reduction due to prefix).
+ *
+ * UUID v4 is probably the safest choice here. There is v1 which is
+ * time-based, but it includes MAC address (which we don't use) and
+ * works with very special timestamp (starting at 1582 etc.). So we
+ * just use v4 and claim this is pseudorandom.
+ *
+ * RFC 9562 added "version 7" (timestamp-based, with a fixed layout), and
+ * "version 8" for custom layouts, which is a more accurate description
+ * of what the generators produce. Those may be requested explicitly.
+ */
+static inline void
+squuid_set_version(unsigned char *uuid, int version)
+{
+	uuid[6] = (uint8_t) ((uuid[6] & 0x0f) | (version << 4));	/* time_hi_and_version */
+	uuid[8] = (uint8_t) ((uuid[8] & 0x3f) | 0x80);	/* clock_seq_hi_and_reserved */
+}
+
+/*
+ * squuid_layout_init
+ *	compute the layout for the given parameters
+ *
+ * node_id -1 means no node ID, stripes 1 means no stripes. Returns 0 on
+ * success, or -1 if the parameters are invalid or the layout fields do
+ * not fit into SQUUID_LAYOUT_BITS.
+ */
+static inline int
+squuid_layout_init(SeqUUIDLayout *layout, int64_t block_length,
+				   int64_t block_count, int node_id, int node_bits,
+				   int node_first, int stripes, int stripe,
+				   int position_bits, int version)
+{
+	int		prefix_bits;
+	int		stripe_bits;
+
+	if (block_length < 1 || block_count < 0 || stripes < 1 ||
+		stripe < 0 || stripe >= stripes || position_bits < 0)
+		return -1;
+
+	prefix_bits = squuid_bits_for_count(block_count);
+	stripe_bits = squuid_bits_for_count(stripes);
+
+	if (node_id < 0)
+		node_bits = 0;
+	else if (node_bits < 0 || node_bits > 16 || node_id >= (1 << node_bits))
+		return -1;
+
+	if (position_bits > SQUUID_LAYOUT_BITS ||
+		prefix_bits + node_bits + stripe_bits + position_bits > SQUUID_LAYOUT_BITS)
+		return -1;
+
+	memset(layout, 0, sizeof(SeqUUIDLayout));
+
+	layout->block_length = block_length;
+	layout->block_count = block_count;
+	layout->version = version;
+
+	layout->prefix_bits = prefix_bits;
+	layout->node_bits = node_bits;
+	layout->node_id = (node_bits > 0) ? (uint64_t) node_id : 0;
+	layout->stripe_bits = stripe_bits;
+	layout->stripe = (uint64_t) stripe;
+	layout->position_bits = position_bits;
+
+	if (node_first)
+	{
+		layout->node_offset = 0;
+		layout->prefix_offset = node_bits;
+	}
+	else
+	{
+		layout->prefix_offset = 0;
+		layout->node_offset = prefix_bits;
+	}
+
+	layout->stripe_offset = prefix_bits + node_bits;
+	layout->position_offset = layout->stripe_offset + stripe_bits;
+	layout->layout_bits = layout->position_offset + position_bits;
+
+	return 0;
+}
+
+/*
+ * squuid_layout_init_v7
+ *	compute layout of UUIDv7 (RFC 9562)
+ *
+ * 48-bit Unix timestamp in milliseconds (the block ID, with one millisecond
+ * per block), then the version, and 12 bits of sub-millisecond precision
+ * (the position in block). The timestamp does not wrap around.
+ */
+static inline void
+squuid_layout_init_v7(SeqUUIDLayout *layout)
+{
+	memset(layout, 0, sizeof(SeqUUIDLayout));
+
+	layout->block_length = 1000;
+	layout->block_count = (int64_t) 1 << SQUUID_LAYOUT_BITS;
+	layout->version = 7;
+
+	layout->prefix_offset = 0;
+	layout->prefix_bits = SQUUID_LAYOUT_BITS;
+
+	/* right after the version */
+	layout->position_offset = SQUUID_LAYOUT_BITS + 4;
+	layout->position_bits = 12;
+	layout->layout_bits = layout->position_offset + layout->position_bits;
+}
+
+/*
+ * squuid_block_id
+ *	determine block ID for the given value
+ *
+ * The block ID wraps around after exactly block_count blocks, even when
+ * block_count is not a power of two.
+ */
+static inline int64_t
+squuid_block_id(const SeqUUIDLayout *layout, int64_t value)
+{
+	int64_t	block = value / layout->block_length;
+	int64_t	count = layout->block_count;
+
+	if (count <= 1)
+		return 0;
+
+	return ((block % count) + count) % count;
+}
+
+/*
+ * squuid_position
+ *	determine position within the block for the given value
+ *
+ * The position is scaled to the number of position bits (and is always 0
+ * when the layout does not include the position).
+ */
+static inline uint64_t
+squuid_position(const SeqUUIDLayout *layout, int64_t value)
+{
+	uint64_t	max_position;
+	int64_t		offset;
+	uint64_t	position;
+
+	if (layout->position_bits == 0)
+		return 0;
+
+	max_position = ((uint64_t) 1 << layout->position_bits) - 1;
+	offset = value % layout->block_length;
+	if (offset < 0)
+		offset = 0;
+
+	position = (uint64_t) ((double) offset / layout->block_length * (max_position + 1));
+
+	return (position < max_position) ? position : max_position;
+}
+
+/*
+ * squuid_stamp
+ *	write the layout fields for the given value into the UUID
+ *
+ * Sets the version flags too, but leaves the remaining bits alone - the
+ * caller is expected to fill them with random data.
+ */
+static inline void
+squuid_stamp(const SeqUUIDLayout *layout, unsigned char *uuid, int64_t value)
+{
+	if (layout->prefix_bits > 0)
+		squuid_set_bits(uuid, layout->prefix_offset,
+						(uint64_t) squuid_block_id(layout, value),
+						layout->prefix_bits);
+
+	if (layout->node_bits > 0)
+		squuid_set_bits(uuid, layout->node_offset, layout->node_id,
+						layout->node_bits);
+
+	if (layout->stripe_bits > 0)
+		squuid_set_bits(uuid, layout->stripe_offset, layout->stripe,
+						layout->stripe_bits);
+
+	if (layout->position_bits > 0)
+		squuid_set_bits(uuid, layout->position_offset,
+						squuid_position(layout, value),
+						layout->position_bits);
+
+	squuid_set_version(uuid, layout->version);
+}
+
+/*
+ * squuid_generate
+ *	build UUID for the given value, with the rest filled from random data
+ */
+static inline void
+squuid_generate(const SeqUUIDLayout *layout, unsigned char *uuid,
+				int64_t value, const unsigned char *random)
+{
+	memcpy(uuid, random, SQUUID_LEN);
+	squuid_stamp(layout, uuid, value);
+}
+
+/*
+ * squuid_time_layout
+ *	layout of uuid_time_nextval(interval_length, interval_count)
+ *
+ * The value passed to squuid_generate is the current time in microseconds
+ * since the Unix epoch.
+ */
+static inline int
+squuid_time_layout(SeqUUIDLayout *layout, int32_t interval_length,
+				   int32_t interval_count)
+{
+	if (interval_length < 1 || interval_count < 1)
+		return -1;
+
+	return squuid_layout_init(layout, (int64_t) interval_length * 1000000,
+							  interval_count, -1, 0, 0, 1, 0, 0, 4);
+}
+
+/*
+ * squuid_counter_layout
+ *	layout of uuid_counter_nextval(name, block_size, block_count)
+ *
+ * The value passed to squuid_generate is the counter value (the clients
+ * are expected to maintain the counter themselves).
+ */
+static inline int
+squuid_counter_layout(SeqUUIDLayout *layout, int32_t block_size,
+					  int32_t block_count)
+{
+	return squuid_layout_init(layout, block_size, block_count,
+							  -1, 0, 0, 1, 0, 0, 4);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif							/* SEQUENTIAL_UUIDS_H */
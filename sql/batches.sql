@@ -0,0 +1,39 @@
+SET client_min_messages = error;
+SET sequential_uuids.random_source = seeded;
+SET sequential_uuids.random_stream = 0;
+SET sequential_uuids.clock_source = virtual;
+
+-- values for the whole batch are reserved at once
+CREATE SEQUENCE batch_seq;
+SELECT uuid_sequence_block(u, 7) AS block, count(*)
+  FROM uuid_sequence_nextval_bulk('batch_seq', 10, 4, 7) AS u
+ GROUP BY 1 ORDER BY 1;
+SELECT last_value FROM batch_seq;
+
+-- batches are sorted, even when wrapping around
+SELECT a = ARRAY(SELECT x FROM unnest(a) AS x ORDER BY x) AS sorted, cardinality(a) AS n
+  FROM (SELECT uuid_sequence_nextval_array('batch_seq', 100, 4, 7) AS a) AS b;
+SELECT last_value FROM batch_seq;
+
+-- sequences with CACHE are used one value at a time
+CREATE SEQUENCE batch_cached CACHE 10;
+SELECT string_agg(uuid_sequence_block(u, 1000)::text, ',') AS vals
+  FROM uuid_sequence_nextval_bulk('batch_cached', 25, 1, 1000) AS u;
+SELECT last_value FROM batch_cached;
+
+-- time-based batches read the clock once
+SELECT count(*) AS n, count(DISTINCT u) AS uniq, count(DISTINCT uuid_time_block(u)) AS blocks
+  FROM uuid_time_nextval_series(50) AS u;
+SELECT a = ARRAY(SELECT x FROM unnest(a) AS x ORDER BY x) AS sorted, cardinality(a) AS n
+  FROM (SELECT uuid_time_nextval_array(100) AS a) AS b;
+
+-- packed batches
+SELECT length(uuid_sequence_nextval_packed('batch_seq', 3)) AS sequence,
+       length(uuid_time_nextval_packed(5)) AS time;
+WITH batch AS (SELECT uuid_time_nextval_array(20) AS a)
+SELECT uuid_unpack_array(uuid_pack(a)) = a AS array_roundtrip,
+       ARRAY(SELECT uuid_unpack(uuid_pack(a))) = a AS setof_roundtrip
+  FROM batch;
+SELECT uuid_unpack_array(''::bytea) AS empty;
+SELECT uuid_unpack('\x00'::bytea);
+SELECT uuid_pack(ARRAY[NULL]::uuid[]);
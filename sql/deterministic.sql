@@ -0,0 +1,22 @@
+\set VERBOSITY terse
+SET sequential_uuids.random_source = seeded;
+SET sequential_uuids.random_seed = 42;
+SET sequential_uuids.random_stream = 0;
+SET sequential_uuids.clock_source = virtual;
+CREATE TABLE run1 AS SELECT uuid_time_nextval_array(10) AS a;
+
+-- setting the seed and clock again restarts them
+SET sequential_uuids.random_seed = 42;
+SET sequential_uuids.virtual_clock_start = 946684800;
+CREATE TABLE run2 AS SELECT uuid_time_nextval_array(10) AS a;
+SELECT r1.a = r2.a AS same FROM run1 r1, run2 r2;
+
+-- a different stream generates different UUIDs, in the same block
+SET sequential_uuids.random_stream = 1;
+SET sequential_uuids.virtual_clock_start = 946684800;
+CREATE TABLE run3 AS SELECT uuid_time_nextval_array(10) AS a;
+SELECT r1.a <> r3.a AS different,
+       uuid_time_block(r1.a[1]) = uuid_time_block(r3.a[1]) AS same_block
+  FROM run1 r1, run3 r3;
+DROP TABLE run3;
+DROP TABLE run1, run2;
@@ -0,0 +1,31 @@
+-- seeded random source and virtual clock, so that the output is stable
+SET client_min_messages = error;
+SET sequential_uuids.random_source = seeded;
+SET sequential_uuids.random_stream = 0;
+SET sequential_uuids.clock_source = virtual;
+
+-- block ID is the first field, followed by the node ID (if any)
+CREATE SEQUENCE layout_seq;
+SELECT setval('layout_seq', 39);
+SELECT substr(uuid_sequence_nextval('layout_seq', 4, 65536)::text, 1, 4) AS prefix;
+SET sequential_uuids.node_id = 5;
+SELECT substr(uuid_sequence_nextval('layout_seq', 4, 65536)::text, 1, 6) AS prefix;
+SET sequential_uuids.node_id_first = on;
+SELECT substr(uuid_sequence_nextval('layout_seq', 4, 65536)::text, 1, 6) AS prefix;
+-- the immutable variant takes the number of node ID bytes before the block ID
+SELECT uuid_block(u, 65536, 1) AS block, uuid_sequence_block(u, 65536) AS stable_block
+  FROM uuid_sequence_nextval('layout_seq', 4, 65536) AS u;
+RESET sequential_uuids.node_id_first;
+RESET sequential_uuids.node_id;
+
+-- version and variant
+SELECT kind, get_byte(uuid_send(u), 6) >> 4 AS version,
+       get_byte(uuid_send(u), 8) >> 6 = 2 AS variant
+  FROM (VALUES ('sequence', uuid_sequence_nextval('layout_seq')),
+               ('time', uuid_time_nextval()),
+               ('v7', uuid_time_nextval_v7()),
+               ('v8', uuid_time_nextval_v8())) AS v(kind, u);
+
+-- UUIDv7 starts with the Unix timestamp in milliseconds
+SET sequential_uuids.virtual_clock_start = 946684800;
+SELECT substr(uuid_time_nextval_v7()::text, 1, 18) AS prefix;
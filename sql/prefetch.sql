@@ -0,0 +1,30 @@
+SET client_min_messages = error;
+SET sequential_uuids.random_source = seeded;
+SET sequential_uuids.random_stream = 0;
+SET sequential_uuids.clock_source = virtual;
+
+-- values are reserved from CACHE 1 sequences in ranges of 10
+SET sequential_uuids.sequence_prefetch = 10;
+CREATE SEQUENCE prefetch_seq;
+SELECT string_agg(uuid_sequence_block(uuid_sequence_nextval('prefetch_seq', 1, 1000), 1000)::text,
+                  ',' ORDER BY i) AS vals
+  FROM generate_series(1, 25) i;
+SELECT last_value FROM prefetch_seq;
+
+-- regular nextval calls do not get the reserved values
+SELECT nextval('prefetch_seq');
+SELECT uuid_sequence_block(uuid_sequence_nextval('prefetch_seq', 1, 1000), 1000) AS val;
+
+-- ranges are not reserved past the end of the sequence
+CREATE SEQUENCE prefetch_short MAXVALUE 12;
+SELECT string_agg(uuid_sequence_block(uuid_sequence_nextval('prefetch_short', 1, 1000), 1000)::text,
+                  ',' ORDER BY i) AS vals
+  FROM generate_series(1, 12) i;
+SELECT last_value FROM prefetch_short;
+
+-- sequences with CACHE are used one value at a time
+CREATE SEQUENCE prefetch_cached CACHE 5;
+SELECT string_agg(uuid_sequence_block(uuid_sequence_nextval('prefetch_cached', 1, 1000), 1000)::text,
+                  ',' ORDER BY i) AS vals
+  FROM generate_series(1, 12) i;
+SELECT last_value FROM prefetch_cached;
@@ -0,0 +1,29 @@
+SET client_min_messages = error;
+SET sequential_uuids.random_source = seeded;
+SET sequential_uuids.random_stream = 0;
+SET sequential_uuids.clock_source = virtual;
+
+-- all UUIDs generated by a backend use the same stripe, stored right
+-- after the block ID (the top two bits of the third byte)
+SET sequential_uuids.stripes = 4;
+CREATE SEQUENCE stripe_seq;
+CREATE TABLE striped AS
+  SELECT uuid_sequence_nextval('stripe_seq', 10, 65536) AS u FROM generate_series(1, 100);
+SELECT count(DISTINCT get_byte(uuid_send(u), 2) >> 6) AS stripes,
+       count(DISTINCT uuid_sequence_block(u, 65536)) AS blocks
+  FROM striped;
+
+-- the number of stripes does not need to be a power of two
+SET sequential_uuids.stripes = 3;
+SELECT count(DISTINCT s) = 1 AND max(s) < 3 AS one_stripe
+  FROM (SELECT get_byte(uuid_send(uuid_sequence_nextval('stripe_seq', 10, 65536)), 2) >> 6 AS s
+          FROM generate_series(1, 100)) AS v;
+
+-- without stripes, the bits are random
+RESET sequential_uuids.stripes;
+CREATE TABLE unstriped AS
+  SELECT uuid_sequence_nextval('stripe_seq', 10, 65536) AS u FROM generate_series(1, 100);
+SELECT count(DISTINCT get_byte(uuid_send(u), 2) >> 6) AS stripes,
+       count(DISTINCT uuid_sequence_block(u, 65536)) AS blocks
+  FROM unstriped;
+DROP TABLE striped, unstriped;
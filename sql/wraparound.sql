@@ -0,0 +1,28 @@
+SET client_min_messages = error;
+SET sequential_uuids.random_source = seeded;
+SET sequential_uuids.random_stream = 0;
+SET sequential_uuids.clock_source = virtual;
+
+-- 7 blocks of 4 values, wraps around after exactly 28 values
+CREATE SEQUENCE wrap_seq;
+SELECT string_agg(uuid_sequence_block(uuid_sequence_nextval('wrap_seq', 4, 7), 7)::text,
+                  ',' ORDER BY i) AS blocks
+  FROM generate_series(1, 30) i;
+
+-- the last block uses only part of the 3-bit prefix (110)
+SELECT setval('wrap_seq', 24, false);
+SELECT substr(uuid_sequence_nextval('wrap_seq', 4, 7)::text, 1, 1) IN ('c', 'd') AS last_block;
+SELECT uuid_sequence_block(uuid_sequence_nextval('wrap_seq', 4, 7), 7) AS block;
+
+-- the sequence wraps around too
+CREATE SEQUENCE cycle_seq MAXVALUE 10 CYCLE;
+SELECT string_agg(uuid_sequence_block(uuid_sequence_nextval('cycle_seq', 2, 5), 5)::text,
+                  ',' ORDER BY i) AS blocks
+  FROM generate_series(1, 12) i;
+
+-- time-based generator with 5 intervals of 2 seconds, one UUID per second
+SET sequential_uuids.virtual_clock_start = 0;
+SET sequential_uuids.virtual_clock_rate = 1;
+SELECT string_agg(uuid_time_block(uuid_time_nextval(2, 5), 2, 5)::text,
+                  ',' ORDER BY i) AS blocks
+  FROM generate_series(1, 13) i;
@@ -0,0 +1,259 @@
+# Concurrency tests of sequential_uuids
+#
+# Runs pgbench with many clients generating UUIDs, and checks that values
+# (sequence or counter) are not handed out twice, and that the layout is
+# the same for all UUIDs generated by a backend.
+
+use strict;
+use warnings;
+
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+# block_size 1 and 2^30 blocks, so that the block ID is the value itself
+my $count = 1073741824;
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+shared_preload_libraries = 'sequential_uuids'
+sequential_uuids.stripes = 4
+max_connections = 40
+max_worker_processes = 8
+max_parallel_workers = 8
+});
+$node->start;
+
+$node->safe_psql(
+	'postgres', q{
+CREATE EXTENSION sequential_uuids;
+CREATE TABLE counter_values (v bigint PRIMARY KEY);
+CREATE TABLE stripe_values (pid int, stripe int);
+});
+
+# shared counter
+$node->pgbench(
+	'--no-vacuum --client=16 --transactions=50',
+	0,
+	[qr{processed: 800/800}],
+	[qr{^$}],
+	'counter values are unique',
+	{
+		'001_counter' => qq{
+INSERT INTO counter_values
+  SELECT uuid_sequence_block(uuid_counter_nextval('tap', 1, $count), $count)
+    FROM generate_series(1, 5);
+}
+	});
+
+is($node->safe_psql('postgres', 'SELECT count(*) FROM counter_values'),
+	'4000', 'all counter values inserted');
+
+# counter with values leased from a sequence
+is( $node->safe_psql(
+		'postgres', qq{
+CREATE SEQUENCE seq_lease;
+SELECT uuid_counter_lease('lease', 'seq_lease', 100);
+SELECT nextval('seq_lease');
+SELECT min(b), max(b), count(DISTINCT b) FROM (
+  SELECT uuid_sequence_block(uuid_counter_nextval('lease', 1, $count), $count) AS b
+    FROM generate_series(1, 100)) AS s;
+}),
+	"1\n101\n1|100|100",
+	'leased counter hands out the leased range');
+
+my ($ret, $stdout, $stderr) =
+  $node->psql('postgres', "SELECT uuid_counter_nextval('lease')");
+like($stderr, qr/reached the end of the leased range/,
+	'leased counter stops at the end of the range');
+
+($ret, $stdout, $stderr) =
+  $node->psql('postgres', "SELECT uuid_counter_lease('lease', 'seq_lease', 100)");
+like($stderr, qr/already exists/, 'values are leased only to new counters');
+
+# each backend uses a single stripe
+$node->pgbench(
+	'--no-vacuum --client=16 --transactions=50',
+	0,
+	[qr{processed: 800/800}],
+	[qr{^$}],
+	'striped UUIDs',
+	{
+		'001_stripes' => q{
+INSERT INTO stripe_values
+  SELECT pg_backend_pid(), get_byte(uuid_send(uuid_time_nextval()), 2) >> 6;
+}
+	});
+
+is( $node->safe_psql(
+		'postgres', q{
+SELECT count(*) FROM (
+  SELECT pid FROM stripe_values GROUP BY pid HAVING count(DISTINCT stripe) > 1) AS s}),
+	'0',
+	'each backend uses a single stripe');
+
+$node->safe_psql(
+	'postgres', q{
+CREATE SEQUENCE seq_nocache;
+CREATE SEQUENCE seq_cached CACHE 10;
+CREATE TABLE nocache_values (v bigint PRIMARY KEY);
+CREATE TABLE cached_values (v bigint PRIMARY KEY);
+CREATE TABLE ordered_values (id bigserial PRIMARY KEY, pid int, v bigint);
+});
+
+# sequences, mixing prefetch, batches and regular nextval calls
+foreach my $seq ('nocache', 'cached')
+{
+	$node->pgbench(
+		'--no-vacuum --client=16 --transactions=50',
+		0,
+		[qr{processed: 800/800}],
+		[qr{^$}],
+		"sequence values are unique ($seq)",
+		{
+			"001_${seq}_prefetch" => qq{
+SET sequential_uuids.sequence_prefetch = 7;
+INSERT INTO ${seq}_values
+  SELECT uuid_sequence_block(uuid_sequence_nextval('seq_$seq', 1, $count), $count)
+    FROM generate_series(1, 3);
+},
+			"001_${seq}_bulk" => qq{
+INSERT INTO ${seq}_values
+  SELECT uuid_sequence_block(u, $count)
+    FROM uuid_sequence_nextval_bulk('seq_$seq', 10, 1, $count) AS u;
+},
+			"001_${seq}_array" => qq{
+INSERT INTO ${seq}_values
+  SELECT uuid_sequence_block(unnest(uuid_sequence_nextval_array('seq_$seq', 5, 1, $count)), $count);
+},
+			"001_${seq}_nextval" => qq{
+INSERT INTO ${seq}_values SELECT nextval('seq_$seq');
+}
+		});
+
+	is( $node->safe_psql(
+			'postgres',
+			"SELECT max(v) <= (SELECT last_value FROM seq_$seq) FROM ${seq}_values"),
+		't',
+		"sequence was not moved back ($seq)");
+}
+
+# each backend sees increasing values
+$node->pgbench(
+	'--no-vacuum --client=16 --transactions=50',
+	0,
+	[qr{processed: 800/800}],
+	[qr{^$}],
+	'ordered sequence values',
+	{
+		'001_ordered' => qq{
+SET sequential_uuids.sequence_prefetch = 4;
+INSERT INTO ordered_values (pid, v)
+  SELECT pg_backend_pid(),
+         uuid_sequence_block(uuid_sequence_nextval('seq_nocache', 1, $count), $count);
+}
+	});
+
+is( $node->safe_psql(
+		'postgres', q{
+SELECT count(*) FROM (
+  SELECT v <= lag(v) OVER (PARTITION BY pid ORDER BY id) AS backwards
+    FROM ordered_values) AS s
+ WHERE backwards}),
+	'0',
+	'sequence values increase within a backend');
+
+# prefetching with concurrent sessions still avoids some nextval calls
+$node->safe_psql(
+	'postgres', q{
+CREATE SEQUENCE seq_prefetch;
+CREATE TABLE prefetch_values (v bigint PRIMARY KEY);
+});
+
+$node->pgbench(
+	'--no-vacuum --client=8 --transactions=50',
+	0,
+	[qr{processed: 400/400}],
+	[qr{^$}],
+	'prefetched sequence values',
+	{
+		'001_prefetch' => qq{
+SET sequential_uuids.sequence_prefetch = 10;
+INSERT INTO prefetch_values
+  SELECT uuid_sequence_block(uuid_sequence_nextval('seq_prefetch', 1, $count), $count)
+    FROM generate_series(1, 5);
+}
+	});
+
+is( $node->safe_psql(
+		'postgres', q{
+SELECT sum(nextval_avoided) > 0 FROM sequential_uuids_stats
+ WHERE sequence = 'seq_prefetch'::regclass}),
+	't',
+	'prefetch avoids nextval calls with concurrent sessions');
+
+# adaptive generator skipping blocks still dense after a wrap-around
+is( $node->safe_psql(
+		'postgres', q{
+CREATE TABLE skip_uuids (u uuid PRIMARY KEY);
+INSERT INTO skip_uuids
+  SELECT uuid_adaptive_nextval('skip', 4000, 3600, 8) FROM generate_series(1, 32000);
+DELETE FROM skip_uuids WHERE uuid_sequence_block(u, 8) IN (2, 3);
+VACUUM skip_uuids;
+SELECT uuid_adaptive_skip_dense('skip', 'skip_uuids_pkey', 0.3, 8);
+SELECT count(DISTINCT b), bool_and(b IN (2, 3)) FROM (
+  SELECT uuid_sequence_block(uuid_adaptive_nextval('skip', 4000, 3600, 8), 8) AS b
+    FROM generate_series(1, 16000)) AS s;
+}),
+	"6\n2|t",
+	'adaptive generator skips dense blocks');
+
+# seeded random source and virtual clock, configured for the database (each
+# SET restarts the random stream, so it can't be done in the script)
+$node->safe_psql(
+	'postgres', q{
+CREATE DATABASE seeded;
+ALTER DATABASE seeded SET client_min_messages = error;
+ALTER DATABASE seeded SET sequential_uuids.random_source = seeded;
+ALTER DATABASE seeded SET sequential_uuids.clock_source = virtual;
+});
+
+$node->safe_psql(
+	'seeded', q{
+CREATE EXTENSION sequential_uuids;
+CREATE TABLE seeded_uuids (u uuid PRIMARY KEY);
+});
+
+$node->pgbench(
+	'--no-vacuum --client=16 --transactions=50',
+	0,
+	[qr{processed: 800/800}],
+	[qr{^$}],
+	'seeded UUIDs are unique across sessions',
+	{
+		'001_seeded' => q{
+INSERT INTO seeded_uuids SELECT uuid_time_nextval() FROM generate_series(1, 5);
+}
+	},
+	'seeded');
+
+# parallel workers use different streams than the leader
+is( $node->safe_psql(
+		'seeded', q{
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 4;
+CREATE TABLE source AS SELECT i FROM generate_series(1, 100000) s(i);
+ANALYZE source;
+CREATE TABLE parallel_uuids AS SELECT uuid_time_nextval() AS u FROM source;
+SELECT count(*) = count(DISTINCT u) FROM parallel_uuids;
+}),
+	't',
+	'seeded UUIDs are unique across parallel workers');
+
+$node->stop;
+
+done_testing();